@@ -45,5 +45,12 @@
 #pragma link C++ defined_in "Constants.h";
 
 #pragma read sourceClass="AnalysisTree::Configuration" targetClass="AnalysisTree::Configuration_v3";
+#pragma read sourceClass="AnalysisTree::Matching" version="[-2]" targetClass="AnalysisTree::Matching" \
+  source="std::map<int,int> match_; std::map<int,int> match_inverted_" target="match_, match_inverted_" \
+  code="{ match_.assign(onfile.match_.begin(), onfile.match_.end()); match_inverted_.assign(onfile.match_inverted_.begin(), onfile.match_inverted_.end()); }";
+#pragma read sourceClass="AnalysisTree::Matching" version="[1-]" targetClass="AnalysisTree::Matching" \
+  source="" target="direct_" code="{ newObj->UpdateIndex(); }";
+#pragma read sourceClass="AnalysisTree::BranchConfig" version="[1-]" targetClass="AnalysisTree::BranchConfig" \
+  source="" target="fields_index_" code="{ newObj->UpdateIndex(); }";
 
 #endif
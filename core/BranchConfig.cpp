@@ -59,32 +59,49 @@ BranchConfig::BranchConfig(std::string name, DetType type, std::string title) :
     VectorConfig<float>::AddField("vtx_z", EventHeaderFields::kVertexZ, "Z coordinate of the vertex, cm");
     VectorConfig<int>::AddField("id", EventHeaderFields::kId, "Always 0, this field is not used for EventHeader and is needed for compatibility with other Container types");
   }
+  UpdateIndex();
 }
 
 Types BranchConfig::GetFieldType(const std::string& sField) const {
-  ShortInt_t id = VectorConfig<int>::GetId(sField);
-  if (id != UndefValueShort) return Types::kInteger;
-
-  id = VectorConfig<float>::GetId(sField);
-  if (id != UndefValueShort) return Types::kFloat;
-
-  id = VectorConfig<bool>::GetId(sField);
-  if (id != UndefValueShort) return Types::kBool;
-
-  return (Types) UndefValueShort;
+  auto search = fields_index_.find(sField);
+  return search != fields_index_.end() ? search->second.first : (Types) UndefValueShort;
 }
 
 ShortInt_t BranchConfig::GetFieldId(const std::string& sField) const {
-  ShortInt_t id = VectorConfig<int>::GetId(sField);
-  if (id != UndefValueShort) return id;
-
-  id = VectorConfig<float>::GetId(sField);
-  if (id != UndefValueShort) return id;
+  auto search = fields_index_.find(sField);
+  return search != fields_index_.end() ? search->second.second : UndefValueShort;
+}
 
-  id = VectorConfig<bool>::GetId(sField);
-  if (id != UndefValueShort) return id;
+void BranchConfig::AddToIndex(const std::string& name) {
+  ShortInt_t id = VectorConfig<int>::GetId(name);
+  if (id != UndefValueShort) {
+    fields_index_[name] = {Types::kInteger, id};
+    return;
+  }
+  id = VectorConfig<float>::GetId(name);
+  if (id != UndefValueShort) {
+    fields_index_[name] = {Types::kFloat, id};
+    return;
+  }
+  id = VectorConfig<bool>::GetId(name);
+  if (id != UndefValueShort) {
+    fields_index_[name] = {Types::kBool, id};
+  }
+}
 
-  return UndefValueShort;
+void BranchConfig::UpdateIndex() {
+  fields_index_.clear();
+  fields_index_.reserve(VectorConfig<int>::map_.size() + VectorConfig<float>::map_.size() + VectorConfig<bool>::map_.size());
+  // same precedence as lookup in the maps: int, float, bool
+  for (const auto& field : VectorConfig<bool>::map_) {
+    fields_index_[field.first] = {Types::kBool, field.second.id_};
+  }
+  for (const auto& field : VectorConfig<float>::map_) {
+    fields_index_[field.first] = {Types::kFloat, field.second.id_};
+  }
+  for (const auto& field : VectorConfig<int>::map_) {
+    fields_index_[field.first] = {Types::kInteger, field.second.id_};
+  }
 }
 
 BranchConfig BranchConfig::Clone(const std::string& name, DetType type) const {
@@ -204,6 +221,7 @@ void BranchConfig::RemoveField(const std::string& name) {
   if (field_type == Types::kInteger) VectorConfig<int>::RemoveField(name, field_id);
   if (field_type == Types::kFloat) VectorConfig<float>::RemoveField(name, field_id);
   if (field_type == Types::kBool) VectorConfig<bool>::RemoveField(name, field_id);
+  UpdateIndex();// ids of the next fields are shifted
 }
 
 void BranchConfig::GuaranteeFieldNameVacancy(const std::string& name) const {
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -85,6 +86,7 @@ class VectorConfig {
 /// A class to store configuration of the Container.
 /**
  * Maybe better design choise would be use composition over inheritance (?)
+ * Type and id of fields are looked up by name in a hash table (transient, rebuilt after reading)
  */
 class BranchConfig : public VectorConfig<int>, public VectorConfig<float>, public VectorConfig<bool> {
 
@@ -110,6 +112,7 @@ class BranchConfig : public VectorConfig<int>, public VectorConfig<float>, publi
   void AddField(const std::string& name, const std::string& title = "") {
     GuaranteeFieldNameVacancy(name);
     VectorConfig<T>::AddField(name, title);
+    AddToIndex(name);
   }
   template<typename T>
   void AddFields(const std::vector<std::string>& names, const std::string& title = "") {
@@ -117,11 +120,15 @@ class BranchConfig : public VectorConfig<int>, public VectorConfig<float>, publi
       GuaranteeFieldNameVacancy(n);
     }
     VectorConfig<T>::AddFields(names, title);
+    for (auto& n : names) {
+      AddToIndex(n);
+    }
   }
   template<typename T>
   void AddField(const std::string& name, ShortInt_t id, const std::string& title = "") {
     GuaranteeFieldNameVacancy(name);
     VectorConfig<T>::AddField(name, id, title);
+    AddToIndex(name);
   }
 
   void RemoveField(const std::string& name);
@@ -162,9 +169,18 @@ class BranchConfig : public VectorConfig<int>, public VectorConfig<float>, publi
 
   ANALYSISTREE_ATTR_NODISCARD BranchConfig CloneAndMerge(const BranchConfig& attached) const;
 
-  bool HasField(const std::string& field) const { return GetFieldId(field) != UndefValueShort; }
+  bool HasField(const std::string& field) const { return fields_index_.find(field) != fields_index_.end(); }
+
+  /**
+   * @brief Rebuilds lookup table of the fields from the maps, called after reading from file
+   */
+  void UpdateIndex();
 
  protected:
+  typedef std::unordered_map<std::string, std::pair<Types, ShortInt_t>> IndexType;
+
+  void AddToIndex(const std::string& name);
+
   void GenerateId();
 
   void GuaranteeFieldNameVacancy(const std::string& name) const;
@@ -174,6 +190,8 @@ class BranchConfig : public VectorConfig<int>, public VectorConfig<float>, publi
   size_t id_{0};
   DetType type_{DetType(UndefValueShort)};
 
+  IndexType fields_index_{};//! name -> type and id of the field
+
   ClassDefOverride(BranchConfig, 4);
 };
 
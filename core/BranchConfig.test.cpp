@@ -41,6 +41,26 @@ TEST(BranchConfig, Basics) {
   EXPECT_EQ(branch_config.GetFieldId("pz"), TrackFields::kPz);
 }
 
+TEST(BranchConfig, RemoveField) {
+  BranchConfig branch_config("RecTrack", DetType::kTrack);
+  branch_config.AddFields<float>({"f0", "f1", "f2"});
+  branch_config.AddField<int>("i0");
+
+  branch_config.RemoveField("f0");
+  EXPECT_FALSE(branch_config.HasField("f0"));
+  EXPECT_EQ(branch_config.GetFieldId("f1"), 0);
+  EXPECT_EQ(branch_config.GetFieldId("f2"), 1);
+  EXPECT_EQ(branch_config.GetFieldType("f2"), Types::kFloat);
+  EXPECT_EQ(branch_config.GetFieldId("i0"), 0);
+  EXPECT_EQ(branch_config.GetFieldType("f0"), Types(UndefValueShort));
+
+  auto clone = branch_config.Clone("SimTrack", DetType::kTrack);
+  EXPECT_EQ(clone.GetFieldId("f2"), 1);
+  EXPECT_EQ(clone.GetFieldType("i0"), Types::kInteger);
+  EXPECT_EQ(clone.GetFieldId("pT"), TrackFields::kPt);
+  EXPECT_THROW(clone.AddField<bool>("f1"), std::runtime_error);
+}
+
 }// namespace
 
 #endif//ANALYSISTREE_CORE_BRANCHCONFIG_TEST_H_
@@ -24,8 +24,9 @@ void Configuration::Streamer(TBuffer& rb) {
     auto version_from_file = rb.ReadVersion(&rs, &rc, Configuration::Class());
     if (version_from_file == Class()->GetClassVersion()) {
       Configuration::Class()->ReadBuffer(rb, this, version_from_file, rs, rc);
-      // populate the transient field
+      // populate the transient fields
       this->matches_index_ = MakeMatchingIndex(matches_);
+      UpdateBranchIndex();
       read_ok = true;
     } else if (version_from_file == 3) {
       //      below structure description for version 3 of this class
@@ -38,8 +39,9 @@ void Configuration::Streamer(TBuffer& rb) {
       this->name_ = conf_v3.name_;
       this->branches_ = conf_v3.branches_;
       this->matches_ = MakeMatchConfigsFromIndex(conf_v3.matches_);
-      // populate the transient field
+      // populate the transient fields
       this->matches_index_ = conf_v3.matches_;
+      UpdateBranchIndex();
       read_ok = true;
     } else {
       Warning(__func__, "Current version of AnalysisTree::Configuration (%d) "
@@ -57,21 +59,28 @@ void Configuration::Streamer(TBuffer& rb) {
 }
 
 BranchConfig& Configuration::GetBranchConfig(const std::string& name) {
-  for (auto& branch : branches_) {
-    if (branch.second.GetName() == name)
-      return branch.second;
-  }
-  throw std::runtime_error("Configuration::GetBranchConfig - no branch " + name);
+  return const_cast<BranchConfig&>(static_cast<const Configuration*>(this)->GetBranchConfig(name));
 }
 
 const BranchConfig& Configuration::GetBranchConfig(const std::string& name) const {
-  for (auto& branch : branches_) {
-    if (branch.second.GetName() == name)
-      return branch.second;
+  auto id = branch_ids_.find(name);
+  if (id != branch_ids_.end()) {
+    auto it = branches_.find(id->second);
+    if (it != branches_.end()) {
+      return it->second;
+    }
   }
   throw std::runtime_error("Configuration::GetBranchConfig - no branch " + name);
 }
 
+void Configuration::UpdateBranchIndex() {
+  branch_ids_.clear();
+  branch_ids_.reserve(branches_.size());
+  for (const auto& branch : branches_) {
+    branch_ids_.emplace(branch.second.GetName(), branch.first);
+  }
+}
+
 void Configuration::Print(Option_t*) const {
   std::cout << "This is a " << name_ << std::endl;
   std::cout << "The Tree has the following branches:" << std::endl;
@@ -173,6 +182,7 @@ void Configuration::RemoveBranchConfig(const std::string& branchname) {
       ++br;
     }
   }
+  branch_ids_.erase(branchname);
   // Remove matchings with this branch
   for (auto ma = matches_index_.begin(); ma != matches_index_.end();) {
     if (ma->first[0] == branchname || ma->first[1] == branchname) {
@@ -8,6 +8,7 @@
 #include <array>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -53,7 +54,8 @@ class Configuration_v3 : public TObject {
 /**
  * Consists of map with configs for all branches and Matching information.
  * Should be written to ROOT file next to the TTree.
- * Needed to read information correctly and decode meaning of the Container objects
+ * Needed to read information correctly and decode meaning of the Container objects.
+ * Branches are looked up by name in a hash table (transient, rebuilt after reading)
  */
 class Configuration : public TObject {
 
@@ -68,7 +70,9 @@ class Configuration : public TObject {
   Configuration& operator=(const Configuration&) = default;
 
   void AddBranchConfig(const BranchConfig& branch) {
-    branches_.emplace(branch.GetId(), branch);
+    if (branches_.emplace(branch.GetId(), branch).second) {
+      branch_ids_.emplace(branch.GetName(), branch.GetId());
+    }
   }
 
   void RemoveBranchConfig(const std::string& branchname);
@@ -143,6 +147,7 @@ class Configuration : public TObject {
       }
       /// DO NOT REINDEX
       branches_.emplace(other_branch);
+      branch_ids_.emplace(other_name, other_id);
     }
   }
 
@@ -152,6 +157,12 @@ class Configuration : public TObject {
   std::vector<MatchingConfig> matches_{};
 
   MatchingIndex matches_index_{};//! transient field in this version
+  std::unordered_map<std::string, size_t> branch_ids_{};//! name -> id of the branch
+
+  /**
+   * @brief Rebuilds lookup table of the branches, called after reading from file
+   */
+  void UpdateBranchIndex();
 
   void AddMatch(const std::string& br1, const std::string& br2, const std::string& data_branch);
 
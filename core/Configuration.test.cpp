@@ -79,6 +79,8 @@ TEST(Configuration, RemoveBranch) {
   config.RemoveBranchConfig("SimTrack");
   EXPECT_EQ(config.GetNumberOfBranches(), 1);
   EXPECT_EQ(config.GetMatches().size(), 0);
+  EXPECT_THROW((void) config.GetBranchConfig("SimTrack"), std::runtime_error);
+  EXPECT_EQ(config.GetBranchConfig("RecTrack").GetId(), rec.GetId());
 }
 
 TEST(Configuration, ReadWrite) {
@@ -106,6 +108,8 @@ TEST(Configuration, ReadWrite) {
     TFile f("configuration_io.root", "read");
     auto config_new = f.Get<Configuration>("Configuration");
     ASSERT_TRUE(config_new);
+    EXPECT_EQ(config_new->GetBranchConfig("test2").GetId(), config.GetBranchConfig("test2").GetId());
+    EXPECT_EQ(config_new->GetBranchConfig("test1").GetFieldId("pid"), ParticleFields::kPid);
   }
 
   delete matching_to_add;
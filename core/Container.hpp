@@ -64,5 +64,19 @@ class Container : public IndexedObject {
   ClassDefOverride(Container, 2);
 };
 
+template<>
+inline std::vector<int>& Container::Vector<int>() { return ints_; }
+template<>
+inline std::vector<float>& Container::Vector<float>() { return floats_; }
+template<>
+inline std::vector<bool>& Container::Vector<bool>() { return bools_; }
+
+template<>
+inline const std::vector<int>& Container::GetVector<int>() const { return ints_; }
+template<>
+inline const std::vector<float>& Container::GetVector<float>() const { return floats_; }
+template<>
+inline const std::vector<bool>& Container::GetVector<bool>() const { return bools_; }
+
 }// namespace AnalysisTree
 #endif//ANALYSISTREE_BASECONTAINER_H
@@ -3,23 +3,86 @@
    Authors: Viktor Klochkov, Ilya Selyuzhenkov */
 #include "Matching.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
 namespace AnalysisTree {
 
-Integer_t AnalysisTree::Matching::GetMatchInverted(AnalysisTree::Integer_t id) const {
-  auto search = match_inverted_.find(id);
-  if (search != match_inverted_.end()) {
-    return search->second;
-  } else {
-    return UndefValueInt;
+void Matching::AddMatch(Integer_t id1, Integer_t id2) {
+  if (id1 < 0 || id2 < 0) {
+    throw std::runtime_error("Matching::AddMatch - negative id: " + std::to_string(id1) + " " + std::to_string(id2));
+  }
+  if (Insert(direct_, id1, id2)) {
+    InsertSorted(match_, id1, id2);
+  }
+  if (Insert(inverted_, id2, id1)) {
+    InsertSorted(match_inverted_, id2, id1);
+  }
+}
+
+/**
+ * @return false if id is already present in the index
+ */
+bool Matching::Insert(std::vector<Integer_t>& index, Integer_t id, Integer_t value) {
+  if (static_cast<size_t>(id) >= index.size()) {
+    index.resize(id + 1, UndefValueInt);
+  }
+  if (index[id] != UndefValueInt) {
+    return false;
+  }
+  index[id] = value;
+  return true;
+}
+
+/**
+ * @brief Ids are unique in pairs, ids filled in increasing order (usual case for the direct matching) are appended
+ */
+void Matching::InsertSorted(PairsType& pairs, Integer_t id, Integer_t value) {
+  if (pairs.empty() || pairs.back().first < id) {
+    pairs.emplace_back(id, value);
+    return;
   }
+  const auto it = std::lower_bound(pairs.begin(), pairs.end(), id,
+                                   [](const PairsType::value_type& pair, Integer_t i) { return pair.first < i; });
+  pairs.emplace(it, id, value);
 }
-Integer_t Matching::GetMatchDirect(Integer_t id) const {
-  auto search = match_.find(id);
-  if (search != match_.end()) {
-    return search->second;
-  } else {
-    return UndefValueInt;
+
+/**
+ * @brief Only entries set by the current matches are reset, so that Clear() does not depend on the size of the index
+ */
+void Matching::Clear() {
+  for (const auto& match : match_) {
+    direct_[match.first] = UndefValueInt;
+  }
+  for (const auto& match : match_inverted_) {
+    inverted_[match.first] = UndefValueInt;
+  }
+  match_.clear();
+  match_inverted_.clear();
+}
+
+void Matching::SetMatches(const MapType& match, const MapType& match_inv) {
+  match_.assign(match.begin(), match.end());
+  match_inverted_.assign(match_inv.begin(), match_inv.end());
+  UpdateIndex();
+}
+
+void Matching::UpdateIndex() {
+  if (!std::is_sorted(match_.begin(), match_.end())) {
+    std::sort(match_.begin(), match_.end());
+  }
+  if (!std::is_sorted(match_inverted_.begin(), match_inverted_.end())) {
+    std::sort(match_inverted_.begin(), match_inverted_.end());
+  }
+  direct_.clear();
+  inverted_.clear();
+  for (const auto& match : match_) {
+    Insert(direct_, match.first, match.second);
+  }
+  for (const auto& match : match_inverted_) {
+    Insert(inverted_, match.first, match.second);
   }
 }
 
-}// namespace AnalysisTree
\ No newline at end of file
+}// namespace AnalysisTree
@@ -7,63 +7,97 @@
 #include "Constants.hpp"
 #include <map>
 #include <utility>
+#include <vector>
 
 namespace AnalysisTree {
 
 /**
- * A class for a matching information
+ * A class for a matching information.
+ * Matches are stored as vectors of (id, matched id) pairs, kept sorted by the first id, in both directions.
+ * Lookups go through dense arrays indexed by channel id (transient, rebuilt after reading), so that
+ * GetMatchDirect() and GetMatchInverted() take constant time and filling does not allocate per pair
  */
 
 class Matching {
 
+ public:
   typedef std::map<Integer_t, Integer_t> MapType;
+  typedef std::vector<std::pair<Integer_t, Integer_t>> PairsType;
 
- public:
   Matching() = default;
+  Matching(const Matching&) = default;
+  Matching(Matching&&) = default;
+  Matching& operator=(Matching&&) = default;
+  Matching& operator=(const Matching&) = default;
   Matching(size_t id1, size_t id2) : branch1_id_(id1), branch2_id_(id2){};
-  Matching(size_t id1, size_t id2, MapType match, MapType match_inverted) : branch1_id_(id1),
-                                                                            branch2_id_(id2),
-                                                                            match_(std::move(match)),
-                                                                            match_inverted_(std::move(match_inverted)){};
+  Matching(size_t id1, size_t id2, const MapType& match, const MapType& match_inverted) : branch1_id_(id1),
+                                                                                          branch2_id_(id2) {
+    SetMatches(match, match_inverted);
+  };
 
   virtual ~Matching() = default;
 
-  void AddMatch(Integer_t id1, Integer_t id2) {
-    match_.insert(std::make_pair(id1, id2));
-    match_inverted_.insert(std::make_pair(id2, id1));
-  }
+  /**
+   * @brief Adds a match between channel id1 of the first branch and channel id2 of the second one.
+   * As for a map, an id which is already matched keeps its first match
+   */
+  void AddMatch(Integer_t id1, Integer_t id2);
 
-  ANALYSISTREE_ATTR_NODISCARD Integer_t GetMatchDirect(Integer_t id) const;
-  ANALYSISTREE_ATTR_NODISCARD Integer_t GetMatchInverted(Integer_t id) const;
+  ANALYSISTREE_ATTR_NODISCARD Integer_t GetMatchDirect(Integer_t id) const { return Find(direct_, id); }
+  ANALYSISTREE_ATTR_NODISCARD Integer_t GetMatchInverted(Integer_t id) const { return Find(inverted_, id); }
   ANALYSISTREE_ATTR_NODISCARD Integer_t GetMatch(Integer_t id, bool is_inverted = false) const {
     return is_inverted ? GetMatchInverted(id) : GetMatchDirect(id);
   }
 
-  ANALYSISTREE_ATTR_NODISCARD const MapType& GetMatches(bool is_inv = false) const {
+  /**
+   * @return copy of the matches as a map, prefer GetMatchPairs() for iteration
+   */
+  ANALYSISTREE_ATTR_NODISCARD MapType GetMatches(bool is_inv = false) const {
+    const auto& pairs = GetMatchPairs(is_inv);
+    return MapType(pairs.begin(), pairs.end());
+  }
+
+  /**
+   * @return (id, matched id) pairs sorted by id
+   */
+  ANALYSISTREE_ATTR_NODISCARD const PairsType& GetMatchPairs(bool is_inv = false) const {
     return is_inv ? match_inverted_ : match_;
   }
 
-  void Clear() {
-    match_.clear();
-    match_inverted_.clear();
+  void Clear();
+
+  void Reserve(size_t n) {
+    match_.reserve(n);
+    match_inverted_.reserve(n);
   }
 
   ANALYSISTREE_ATTR_NODISCARD size_t GetBranch1Id() const { return branch1_id_; }
   ANALYSISTREE_ATTR_NODISCARD size_t GetBranch2Id() const { return branch2_id_; }
 
-  void SetMatches(MapType match, MapType match_inv) {
-    match_ = std::move(match);
-    match_inverted_ = std::move(match_inv);
-  }
+  void SetMatches(const MapType& match, const MapType& match_inv);
+
+  /**
+   * @brief Sorts the pairs and rebuilds lookup arrays from them, called after reading from file
+   */
+  void UpdateIndex();
 
  protected:
+  static Integer_t Find(const std::vector<Integer_t>& index, Integer_t id) {
+    return id >= 0 && static_cast<size_t>(id) < index.size() ? index[id] : UndefValueInt;
+  }
+  static bool Insert(std::vector<Integer_t>& index, Integer_t id, Integer_t value);
+  static void InsertSorted(PairsType& pairs, Integer_t id, Integer_t value);
+
   size_t branch1_id_{0};
   size_t branch2_id_{0};
 
-  MapType match_{};
-  MapType match_inverted_{};//TODO is there a better way? Boost.Bimap?
+  PairsType match_{};///< sorted on filling and after reading
+  PairsType match_inverted_{};
+
+  std::vector<Integer_t> direct_{};  //! direct_[id1] = id2 or UndefValueInt
+  std::vector<Integer_t> inverted_{};//! inverted_[id2] = id1 or UndefValueInt
 
-  ClassDef(Matching, 2)
+  ClassDef(Matching, 3)
 };
 
 }// namespace AnalysisTree
@@ -8,6 +8,9 @@
 
 #include "Matching.hpp"
 
+#include <TFile.h>
+#include <TTree.h>
+
 namespace {
 
 using namespace AnalysisTree;
@@ -34,6 +37,56 @@ TEST(Matching, Basics) {
   ASSERT_EQ(matching.GetMatch(1, true), UndefValueInt);
 }
 
+TEST(Matching, Order) {
+  Matching matching(0, 1);
+  matching.AddMatch(3, 1);
+  matching.AddMatch(1, 7);
+  matching.AddMatch(2, 1);// 1 is already matched in the inverted direction
+  matching.AddMatch(3, 5);// 3 is already matched in the direct direction
+
+  const Matching::PairsType direct{{1, 7}, {2, 1}, {3, 1}};
+  const Matching::PairsType inverted{{1, 3}, {5, 3}, {7, 1}};
+  EXPECT_EQ(matching.GetMatchPairs(), direct);
+  EXPECT_EQ(matching.GetMatchPairs(true), inverted);
+  EXPECT_EQ(matching.GetMatches().at(3), 1);
+  EXPECT_EQ(matching.GetMatches(true).count(5), 1);
+  EXPECT_EQ(matching.GetMatch(3), 1);
+  EXPECT_EQ(matching.GetMatch(1, true), 3);
+  EXPECT_EQ(matching.GetMatch(100), UndefValueInt);
+  EXPECT_EQ(matching.GetMatch(-1), UndefValueInt);
+
+  matching.Clear();
+  EXPECT_EQ(matching.GetMatches().size(), 0);
+  EXPECT_EQ(matching.GetMatch(3), UndefValueInt);
+  matching.AddMatch(3, 2);
+  EXPECT_EQ(matching.GetMatch(3), 2);
+  EXPECT_EQ(matching.GetMatch(2, true), 3);
+}
+
+TEST(Matching, Write) {
+  auto* matching = new Matching(0, 1);
+  for (int i = 0; i < 10; ++i) {
+    matching->AddMatch(i, 9 - i);
+  }
+
+  TFile output_file("Test_WriteMatching.root", "recreate");
+  auto* tree = new TTree("TestMatchingTree", "");
+  tree->Branch("matching", &matching);
+  tree->Fill();
+  tree->Write();
+  output_file.Close();
+
+  Matching* new_matching = nullptr;
+  TFile input_file("Test_WriteMatching.root", "read");
+  tree = (TTree*) input_file.Get("TestMatchingTree");
+  tree->SetBranchAddress("matching", &new_matching);
+  tree->GetEntry(0L);
+
+  EXPECT_EQ(new_matching->GetMatches(), matching->GetMatches());
+  EXPECT_EQ(new_matching->GetMatch(2), 7);
+  EXPECT_EQ(new_matching->GetMatch(2, true), 7);
+}
+
 }// namespace
 
 #endif//ANALYSISTREE_CORE_MATCHING_TEST_HPP_
@@ -0,0 +1,76 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include "PdgTable.hpp"
+
+#include <TDatabasePDG.h>
+#include <THashList.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace AnalysisTree {
+
+constexpr PdgCode_t PdgTable::kDenseSize;
+
+const PdgTable& PdgTable::Instance() {
+  static const PdgTable table;
+  return table;
+}
+
+PdgTable::PdgTable() : dense_(2 * kDenseSize, Properties{-1.f, 0}) {
+  auto* db = TDatabasePDG::Instance();
+  if (db->ParticleList() == nullptr) {
+    db->ReadPDGTable();
+  }
+  for (const auto* object : *db->ParticleList()) {
+    const auto* particle = static_cast<const TParticlePDG*>(object);
+    const PdgCode_t pdg = particle->PdgCode();
+    const Properties properties{static_cast<Floating_t>(particle->Mass()), static_cast<Integer_t>(particle->Charge() / 3)};
+    if (pdg > -kDenseSize && pdg < kDenseSize) {
+      dense_[pdg + kDenseSize] = properties;
+    } else {
+      sparse_.emplace(pdg, properties);
+    }
+    ++n_particles_;
+  }
+}
+
+bool PdgTable::IsKnown(PdgCode_t pdg) const {
+  if (pdg > 1000000000) {
+    return true;
+  }
+  if (pdg > -kDenseSize && pdg < kDenseSize && dense_[pdg + kDenseSize].first >= 0.f) {
+    return true;
+  }
+  Properties properties;
+  return sparse_.find(pdg) != sparse_.end() || GetFromDatabase(pdg, properties);
+}
+
+PdgTable::Properties PdgTable::GetSlow(PdgCode_t pdg) const {
+  if (pdg > 1000000000) {//100ZZZAAA0
+    const auto A = (pdg % 10000) / 10;
+    const auto Z = (pdg % 10000000) / 10000;
+    return {A * 0.938f /* GeV */, static_cast<Integer_t>(Z)};
+  }
+  auto it = sparse_.find(pdg);
+  if (it != sparse_.end()) {
+    return it->second;
+  }
+  Properties properties;
+  if (!GetFromDatabase(pdg, properties)) {// added to TDatabasePDG after the table was built
+    throw std::runtime_error("PdgTable - particle " + std::to_string(pdg) + " is not known");
+  }
+  return properties;
+}
+
+bool PdgTable::GetFromDatabase(PdgCode_t pdg, Properties& properties) {
+  const auto* particle = TDatabasePDG::Instance()->GetParticle(pdg);
+  if (particle == nullptr) {
+    return false;
+  }
+  properties = {static_cast<Floating_t>(particle->Mass()), static_cast<Integer_t>(particle->Charge() / 3)};
+  return true;
+}
+
+}// namespace AnalysisTree
@@ -0,0 +1,69 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_CORE_PDGTABLE_HPP_
+#define ANALYSISTREE_CORE_PDGTABLE_HPP_
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Constants.hpp"
+
+namespace AnalysisTree {
+
+/**
+ * Mass and charge of particles by PDG code, copied once from TDatabasePDG.
+ * Codes with |pdg| < kDenseSize (leptons, photons, light mesons and baryons, hyperons) are looked up in a dense array,
+ * other codes in a hash map. Nuclei (100ZZZAAAI) are calculated from the code.
+ * The table is built on the first call of Instance() and is not modified afterwards, so it can be used from several threads.
+ * Particles added to TDatabasePDG after that are still found, with a slower lookup
+ */
+class PdgTable {
+ public:
+  static const PdgTable& Instance();
+
+  /**
+   * @return mass in GeV, A * 0.938 GeV for nuclei
+   * @throws std::runtime_error if the particle is not known
+   */
+  ANALYSISTREE_ATTR_NODISCARD Floating_t GetMass(PdgCode_t pdg) const { return Get(pdg).first; }
+
+  /**
+   * @return charge in units of e, Z for nuclei
+   * @throws std::runtime_error if the particle is not known
+   */
+  ANALYSISTREE_ATTR_NODISCARD Integer_t GetCharge(PdgCode_t pdg) const { return Get(pdg).second; }
+
+  ANALYSISTREE_ATTR_NODISCARD bool IsKnown(PdgCode_t pdg) const;
+
+  ANALYSISTREE_ATTR_NODISCARD size_t GetNParticles() const { return n_particles_; }
+
+  static constexpr PdgCode_t kDenseSize = 4096;
+
+ private:
+  typedef std::pair<Floating_t, Integer_t> Properties;///< mass and charge
+
+  PdgTable();
+
+  ANALYSISTREE_ATTR_NODISCARD Properties Get(PdgCode_t pdg) const {
+    if (pdg > -kDenseSize && pdg < kDenseSize) {
+      const auto& properties = dense_[pdg + kDenseSize];
+      if (properties.first >= 0.f) {
+        return properties;
+      }
+    }
+    return GetSlow(pdg);
+  }
+
+  ANALYSISTREE_ATTR_NODISCARD Properties GetSlow(PdgCode_t pdg) const;
+  static bool GetFromDatabase(PdgCode_t pdg, Properties& properties);
+
+  std::vector<Properties> dense_{};///< indexed with pdg + kDenseSize, negative mass for unknown codes
+  std::unordered_map<PdgCode_t, Properties> sparse_{};
+  size_t n_particles_{0};
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_CORE_PDGTABLE_HPP_
@@ -0,0 +1,44 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_CORE_PDGTABLE_TEST_HPP_
+#define ANALYSISTREE_CORE_PDGTABLE_TEST_HPP_
+
+#include <gtest/gtest.h>
+
+#include "PdgTable.hpp"
+
+#include <TDatabasePDG.h>
+#include <THashList.h>
+
+#include <stdexcept>
+
+namespace {
+
+using namespace AnalysisTree;
+
+TEST(PdgTable, Basics) {
+  const auto& table = PdgTable::Instance();
+  auto* db = TDatabasePDG::Instance();
+
+  ASSERT_EQ(table.GetNParticles(), static_cast<size_t>(db->ParticleList()->GetEntries()));
+  for (const auto* object : *db->ParticleList()) {
+    const auto* particle = static_cast<const TParticlePDG*>(object);
+    const auto pdg = particle->PdgCode();
+    EXPECT_TRUE(table.IsKnown(pdg));
+    EXPECT_FLOAT_EQ(table.GetMass(pdg), particle->Mass()) << pdg;
+    EXPECT_EQ(table.GetCharge(pdg), int(particle->Charge() / 3)) << pdg;
+  }
+
+  EXPECT_FLOAT_EQ(table.GetMass(1000020040), 4 * 0.938f);// He4
+  EXPECT_EQ(table.GetCharge(1000020040), 2);
+
+  // absent in the table and in TDatabasePDG, which is shared with other tests and is not modified here
+  ASSERT_EQ(db->GetParticle(123456789), nullptr);
+  EXPECT_FALSE(table.IsKnown(123456789));
+  EXPECT_THROW((void) table.GetMass(123456789), std::runtime_error);
+  EXPECT_THROW((void) table.GetCharge(123456789), std::runtime_error);
+}
+}// namespace
+
+#endif//ANALYSISTREE_CORE_PDGTABLE_TEST_HPP_
@@ -3,7 +3,7 @@
    Authors: Viktor Klochkov, Eugeny Kashirin, Ilya Selyuzhenkov */
 #include "Track.hpp"
 
-#include <TDatabasePDG.h>
+#include "PdgTable.hpp"
 
 #include <iostream>
 
@@ -26,35 +26,11 @@ bool operator==(const Track& that, const Track& other) noexcept {
 }
 
 float Track::GetMassByPdgId(PdgCode_t pdg) {
-
-  if (pdg > 1000000000) {//100ZZZAAA0
-    auto A = (pdg % 10000) / 10;
-    return A * 0.938f /* GeV */;
-  }
-  auto db = TDatabasePDG::Instance();
-  auto particle = db->GetParticle(pdg);
-
-  if (particle) {
-    return particle->Mass();
-  } else {
-    throw std::runtime_error("Mass of " + std::to_string(pdg) + " is not known");
-  }
+  return PdgTable::Instance().GetMass(pdg);
 }
 
 int Track::GetChargeByPdgId(PdgCode_t pdg) {
-
-  if (pdg > 1000000000) {//100ZZZAAA0
-    auto Z = (pdg % 10000000) / 10000;
-    return Z;
-  }
-  auto db = TDatabasePDG::Instance();
-  auto particle = db->GetParticle(pdg);
-
-  if (particle) {
-    return int(particle->Charge() / 3);
-  } else {
-    throw std::runtime_error("Mass of " + std::to_string(pdg) + " is not known");
-  }
+  return PdgTable::Instance().GetCharge(pdg);
 }
 
 }// namespace AnalysisTree
\ No newline at end of file
@@ -0,0 +1,87 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include <AnalysisEntry.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace AnalysisTree;
+
+namespace {
+std::atomic<bool> is_count_allocations{false};
+std::atomic<long> n_allocations{0};
+}// namespace
+
+/**
+ * Global operator new is replaced to count heap allocations made inside of AnalysisEntry::FillValues()
+ */
+void* operator new(std::size_t size) {
+  if (is_count_allocations) ++n_allocations;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+/**
+ * Measures time and number of heap allocations per event of AnalysisEntry::FillValues()
+ */
+void benchmark_analysis_entry(int n_events, int n_tracks, int n_vars);
+
+int main(int argc, char* argv[]) {
+  const int n_events = argc > 1 ? std::stoi(argv[1]) : 1000;
+  const int n_tracks = argc > 2 ? std::stoi(argv[2]) : 1000;
+  const int n_vars = argc > 3 ? std::stoi(argv[3]) : 30;
+  benchmark_analysis_entry(n_events, n_tracks, n_vars);
+  return 0;
+}
+
+void benchmark_analysis_entry(int n_events, int n_tracks, int n_vars) {
+  BranchConfig config("RecTracks", DetType::kTrack);
+  config.AddField<float>("chi2", "test field");
+  Configuration configuration;
+  configuration.AddBranchConfig(config);
+
+  auto* tracks = new TrackDetector(config.GetId());
+  for (int i = 0; i < n_tracks; ++i) {
+    auto& track = tracks->AddChannel(config);
+    track.SetMomentum(0.01f * i, 0.5f, 1.f);
+    track.SetField(0.1f * i, config.GetFieldId("chi2"));
+  }
+  Branch branch(config, tracks);
+
+  const std::vector<std::string> field_names{"px", "py", "pz", "pT", "phi", "eta", "p", "chi2"};
+  std::vector<Variable> vars;
+  for (int i = 0; i < n_vars; ++i) {
+    vars.emplace_back("RecTracks", field_names.at(i % field_names.size()));
+  }
+  Cuts cuts("cuts", {RangeCut("RecTracks.chi2", 0., 100.)});
+  Cuts branch_cuts("branch_cuts", {RangeCut("RecTracks.px", 0., 0.005 * n_tracks)});
+  branch_cuts.Init(configuration);
+
+  AnalysisEntry entry(vars, &cuts);
+  entry.AddBranch(branch, &branch_cuts);
+  entry.Init(configuration, {});
+
+  entry.FillValues();// warm-up: scratch buffers reach their size
+
+  n_allocations = 0;
+  is_count_allocations = true;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n_events; ++i) {
+    entry.FillValues();
+  }
+  auto end = std::chrono::steady_clock::now();
+  is_count_allocations = false;
+
+  std::chrono::duration<double, std::micro> elapsed = end - start;
+  std::cout << "AnalysisEntry::FillValues - " << elapsed.count() / n_events << " us per event with "
+            << n_tracks << " channels, " << n_vars << " variables and " << entry.GetValues().size() << " accepted rows\n"
+            << "heap allocations per event: " << double(n_allocations) / n_events << std::endl;
+}
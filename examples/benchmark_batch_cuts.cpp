@@ -0,0 +1,80 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include <Branch.hpp>
+#include <BranchChannel.hpp>
+#include <Cuts.hpp>
+#include <SimpleCut.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace AnalysisTree;
+
+/**
+ * Compares time per event of Cuts::Apply() called for each channel with Cuts::ApplyBatch() over the whole branch
+ */
+void benchmark_batch_cuts(int n_events, int n_tracks);
+
+int main(int argc, char* argv[]) {
+  const int n_events = argc > 1 ? std::stoi(argv[1]) : 1000;
+  const int n_tracks = argc > 2 ? std::stoi(argv[2]) : 1000;
+  benchmark_batch_cuts(n_events, n_tracks);
+  return 0;
+}
+
+void benchmark_batch_cuts(int n_events, int n_tracks) {
+  BranchConfig config("RecTracks", DetType::kTrack);
+  config.AddField<float>("chi2", "test field");
+  config.AddField<int>("nhits", "test field");
+  Configuration configuration;
+  configuration.AddBranchConfig(config);
+
+  auto* tracks = new TrackDetector(config.GetId());
+  for (int i = 0; i < n_tracks; ++i) {
+    auto& track = tracks->AddChannel(config);
+    track.SetMomentum(0.01f * i, 0.5f, 1.f);
+    track.SetField(0.1f * i, config.GetFieldId("chi2"));
+    track.SetField(i % 12, config.GetFieldId("nhits"));
+  }
+  Branch branch(config, tracks);
+
+  Cuts cuts("cuts", {RangeCut("RecTracks.chi2", 0., 0.05 * n_tracks),
+                     RangeCut("RecTracks.pT", 0.5, 5.),
+                     EqualsCut("RecTracks.nhits", 4)});
+  cuts.Init(configuration);
+
+  std::vector<char> mask;
+  std::vector<double> column, values;
+  cuts.ApplyBatch(branch, mask, column, values);// warm-up: scratch buffers reach their size
+
+  long n_passed_scalar{0};
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n_events; ++i) {
+    for (size_t i_channel = 0; i_channel < branch.size(); ++i_channel) {
+      n_passed_scalar += cuts.Apply(branch[i_channel], values);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::micro> elapsed_scalar = end - start;
+
+  long n_passed_batch{0};
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n_events; ++i) {
+    cuts.ApplyBatch(branch, mask, column, values);
+    for (auto passed : mask) {
+      n_passed_batch += passed;
+    }
+  }
+  end = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::micro> elapsed_batch = end - start;
+
+  std::cout << "Cuts::Apply per channel - " << elapsed_scalar.count() / n_events << " us per event\n"
+            << "Cuts::ApplyBatch        - " << elapsed_batch.count() / n_events << " us per event\n"
+            << n_tracks << " channels, " << n_passed_batch / n_events << " accepted" << std::endl;
+  if (n_passed_scalar != n_passed_batch) {
+    std::cout << "Cuts::ApplyBatch - result differs from per channel Cuts::Apply!" << std::endl;
+  }
+}
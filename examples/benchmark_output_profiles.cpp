@@ -0,0 +1,88 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include <Chain.hpp>
+#include <OutputProfile.hpp>
+#include <TaskManager.hpp>
+#include <ToyMC.hpp>
+
+#include <TFile.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace AnalysisTree;
+
+/**
+ * Writes ToyMC data with every output profile and reports write speed, read speed and file size
+ */
+void benchmark_output_profiles(int n_events);
+
+int main(int argc, char* argv[]) {
+  const int n_events = argc > 1 ? std::stoi(argv[1]) : 10000;
+  benchmark_output_profiles(n_events);
+  return 0;
+}
+
+void benchmark_output_profiles(int n_events) {
+  using Clock = std::chrono::steady_clock;
+  auto seconds = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+  struct Result {
+    std::string name;
+    double write_speed;
+    double read_speed;
+    double size;
+  };
+  std::vector<Result> results{};
+
+  for (auto profile : {eOutputProfile::kDefault, eOutputProfile::kFastWrite, eOutputProfile::kArchival, eOutputProfile::kAnalysis}) {
+    const auto name = OutputProfile::GetName(profile);
+    const auto filename = "benchmark_" + name + ".root";
+
+    auto* man = TaskManager::GetInstance();
+    auto* toy_mc = new ToyMC<std::default_random_engine>;
+    man->AddTask(toy_mc);
+    man->SetOutputName(filename, "tTree");
+    man->SetOutputProfile(profile);
+    man->SetIsWriteHashInfo(false);
+
+    const auto write_start = Clock::now();
+    man->Init();
+    man->Run(n_events);
+    man->Finish();
+    const auto write_time = seconds(write_start);
+    man->ClearTasks();
+    delete toy_mc;
+
+    const auto read_start = Clock::now();
+    Chain chain(filename, "tTree");
+    chain.InitPointersToBranches({});
+    const auto n_entries = chain.GetEntries();
+    for (long long i = 0; i < n_entries; ++i) {
+      chain.GetEntry(i);
+    }
+    const auto read_time = seconds(read_start);
+
+    std::unique_ptr<TFile> file{TFile::Open(filename.c_str(), "read")};
+    const auto size = static_cast<double>(file->GetSize()) / 1024. / 1024.;
+
+    results.push_back({name, n_events / write_time, n_entries / read_time, size});
+  }
+  TaskManager::GetInstance()->SetOutputProfile(eOutputProfile::kDefault);
+
+  std::cout << std::left << std::setw(12) << "profile" << std::right
+            << std::setw(14) << "write, ev/s"
+            << std::setw(14) << "read, ev/s"
+            << std::setw(14) << "size, MB" << "\n";
+  for (const auto& result : results) {
+    std::cout << std::left << std::setw(12) << result.name << std::right
+              << std::setw(14) << result.write_speed
+              << std::setw(14) << result.read_speed
+              << std::setw(14) << result.size << "\n";
+  }
+}
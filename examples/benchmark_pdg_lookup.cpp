@@ -0,0 +1,74 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include <PdgTable.hpp>
+
+#include <TDatabasePDG.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace AnalysisTree;
+
+/**
+ * Compares lookup of mass and charge of typical simulated particles with PdgTable and with TDatabasePDG
+ */
+void benchmark_pdg_lookup(int n_lookups);
+
+int main(int argc, char* argv[]) {
+  const int n_lookups = argc > 1 ? std::stoi(argv[1]) : 100000000;
+  benchmark_pdg_lookup(n_lookups);
+  return 0;
+}
+
+void benchmark_pdg_lookup(int n_lookups) {
+  using Clock = std::chrono::steady_clock;
+  auto seconds = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+  const std::vector<PdgCode_t> pdgs{211, -211, 111, 321, -321, 310, 130, 2212, -2212, 2112, 3122, 3312, 3334, 11, -11, 13, 22, 4122, 1000020040};
+  std::vector<PdgCode_t> sample(1 << 16);
+  std::mt19937 engine(42);
+  std::uniform_int_distribution<size_t> distribution(0, pdgs.size() - 1);
+  for (auto& pdg : sample) {
+    pdg = pdgs[distribution(engine)];
+  }
+
+  auto* db = TDatabasePDG::Instance();
+  auto database_lookup = [db](PdgCode_t pdg, Floating_t& mass, Integer_t& charge) {
+    if (pdg > 1000000000) {
+      mass = (pdg % 10000) / 10 * 0.938f;
+      charge = static_cast<Integer_t>((pdg % 10000000) / 10000);
+      return;
+    }
+    const auto* particle = db->GetParticle(pdg);
+    mass = particle->Mass();
+    charge = int(particle->Charge() / 3);
+  };
+  const auto& table = PdgTable::Instance();
+
+  double sum{0.};
+  auto start = Clock::now();
+  for (int i = 0; i < n_lookups; ++i) {
+    Floating_t mass;
+    Integer_t charge;
+    database_lookup(sample[i & (sample.size() - 1)], mass, charge);
+    sum += mass + charge;
+  }
+  const auto database_time = seconds(start);
+
+  start = Clock::now();
+  for (int i = 0; i < n_lookups; ++i) {
+    const auto pdg = sample[i & (sample.size() - 1)];
+    sum -= table.GetMass(pdg) + table.GetCharge(pdg);
+  }
+  const auto table_time = seconds(start);
+
+  std::cout << std::left << std::setw(14) << "lookup" << std::right << std::setw(14) << "ns/lookup" << "\n"
+            << std::left << std::setw(14) << "TDatabasePDG" << std::right << std::setw(14) << 1e9 * database_time / n_lookups << "\n"
+            << std::left << std::setw(14) << "PdgTable" << std::right << std::setw(14) << 1e9 * table_time / n_lookups << "\n"
+            << "speedup " << database_time / table_time << ", checksum " << sum << std::endl;
+}
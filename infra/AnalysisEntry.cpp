@@ -8,6 +8,52 @@
 
 namespace AnalysisTree {
 
+AnalysisEntry::AnalysisEntry(const AnalysisEntry& other) {
+  *this = other;
+}
+
+AnalysisEntry& AnalysisEntry::operator=(const AnalysisEntry& other) {
+  if (this == &other) {
+    return *this;
+  }
+  for (auto& br : branches_) {
+    delete br.first;
+  }
+  branches_.clear();
+  for (const auto& br : other.branches_) {
+    branches_.emplace_back(new Branch(*br.first), br.second);
+  }
+  vars_ = other.vars_;
+  var4weight_ = other.var4weight_;
+  cuts_ = other.cuts_;
+  branch_names_ = other.branch_names_;
+  eve_header_indices_ = other.eve_header_indices_;
+  non_eve_header_indices_ = other.non_eve_header_indices_;
+  matching_ = other.matching_;
+  is_inverted_matching_ = other.is_inverted_matching_;
+  values_ = other.values_;
+  weights_ = other.weights_;
+
+  spare_rows_.clear();
+  column_ = other.column_;
+  cut_values_ = other.cut_values_;
+  bound_cuts_ = other.bound_cuts_;
+  has_cuts_ = other.has_cuts_;
+  is_batch_cuts_ = other.is_batch_cuts_;
+  mask_ = other.mask_;
+  cuts_mask_ = other.cuts_mask_;
+  cache_ = other.cache_;
+  cache_columns_ = other.cache_columns_;
+  cached_values_ = other.cached_values_;
+  branch_ids_ = other.branch_ids_;
+  channels_.clear();
+  channel_ptrs_.clear();
+  if (!other.channels_.empty()) {// channels of other point to its own branches
+    InitChannels();
+  }
+  return *this;
+}
+
 AnalysisEntry::~AnalysisEntry() {
   for (auto& br : branches_) {
     delete br.first;
@@ -18,85 +64,123 @@ void AnalysisEntry::AddBranch(const Branch& branch, Cuts* cuts) {
   branches_.emplace_back(std::make_pair(new Branch(branch), cuts));
 }
 
-bool AnalysisEntry::ApplyCutOnBranch(const Branch& br, Cuts* cuts, int i_channel) const {
-  if (cuts && !cuts->Apply(br[i_channel])) { return false; }
-  return !cuts_ || cuts_->Apply(br[i_channel]);
+bool AnalysisEntry::ApplyCuts() {
+  for (size_t i = 0; i < branches_.size(); ++i) {
+    const auto* cuts = branches_[i].second;
+    if (cuts != nullptr && !cuts->Apply(channels_[i], cut_values_)) {
+      return false;
+    }
+  }
+  return !cuts_ || bound_cuts_.ApplyBound(channel_ptrs_, cut_values_);
 }
 
-bool AnalysisEntry::ApplyCutOnBranches(std::vector<const Branch*>& br, std::vector<Cuts*>& cuts, std::vector<int>& ch) const {
-  if (br.size() != cuts.size() || cuts.size() != ch.size()) {
-    throw std::runtime_error("AnalysisTree::AnalysisEntry::ApplyCutOnBranches() - Branch, Cuts and Ch vectors must have the same size");
-  }
-  bool ok{true};
-  std::vector<const BranchChannel*> bch_vec;
-  std::vector<size_t> id_vec;
-  bch_vec.reserve(br.size());
-  id_vec.reserve(br.size());
-  for (int i = 0; i < br.size(); i++) {
-    BranchChannel* bchptr = new BranchChannel(br.at(i), ch.at(i));
-    if (cuts.at(i) != nullptr) {
-      if (!cuts.at(i)->Apply(*bchptr)) {
-        ok = false;
-        delete bchptr;
-        break;
-      }
+bool AnalysisEntry::ApplyEveHeaderCuts() {
+  for (auto ehi : eve_header_indices_) {
+    const auto* cuts = branches_[ehi].second;
+    if (cuts != nullptr && !cuts->Apply(channels_[ehi], cut_values_)) {
+      return false;
     }
-    bch_vec.emplace_back(bchptr);
-    id_vec.emplace_back(br.at(i)->GetId());
   }
-  bool result = ok && (!cuts_ || cuts_->Apply(bch_vec, id_vec));
-  for (auto& bv : bch_vec) {
-    delete bv;
-  }
-  return result;
+  return true;
 }
 
-bool AnalysisEntry::ApplyCutOnBranches(const Branch& br1, Cuts* cuts1, int ch1, const Branch& br2, Cuts* cuts2, int ch2) const {
-  Branch* br1_ptr = new Branch(std::move(br1));
-  Branch* br2_ptr = new Branch(std::move(br2));
-  std::vector<const Branch*> br_vec{br1_ptr, br2_ptr};
-  std::vector<Cuts*> cuts_vec{cuts1, cuts2};
-  std::vector<int> ch_vec{ch1, ch2};
-  bool result = ApplyCutOnBranches(br_vec, cuts_vec, ch_vec);
-  delete br1_ptr;
-  delete br2_ptr;
-  return result;
+/**
+* @brief ApplyCutsBatch evaluates branch and entry cuts for all channels of the branch i_branch
+* and stores the result in mask_
+*/
+void AnalysisEntry::ApplyCutsBatch(size_t i_branch) {
+  const auto& branch = *branches_[i_branch].first;
+  const auto* branch_cuts = branches_[i_branch].second;
+  if (branch_cuts != nullptr) {
+    branch_cuts->ApplyBatch(branch, mask_, column_, cut_values_);
+  } else {
+    mask_.assign(branch.size(), 1);
+  }
+  if (cuts_ != nullptr) {
+    cuts_->ApplyBatch(branch, cuts_mask_, column_, cut_values_);
+    for (size_t i = 0; i < mask_.size(); ++i) {
+      mask_[i] &= cuts_mask_[i];
+    }
+  }
 }
 
-double AnalysisEntry::FillVariable(const Variable& var, std::vector<const Branch*>& br, std::vector<int>& id) {
-  if (br.size() != id.size()) {
-    throw std::runtime_error("AnalysisTree::AnalysisEntry::FillVariable() - Branch and Id vectors must have the same size");
+/**
+* @brief NewRow returns a row of values_ for the next accepted channel. Rows released
+* from the previous event are reused together with their buffers
+*/
+std::vector<double>& AnalysisEntry::NewRow() {
+  if (spare_rows_.empty()) {
+    values_.emplace_back(vars_.size());
+  } else {
+    values_.emplace_back(std::move(spare_rows_.back()));
+    spare_rows_.pop_back();
+    values_.back().resize(vars_.size());
   }
-  std::vector<const BranchChannel*> bch_vec;
-  std::vector<size_t> id_vec;
-  bch_vec.reserve(br.size());
-  id_vec.reserve(br.size());
-  for (int i = 0; i < br.size(); i++) {
-    BranchChannel* bchptr = new BranchChannel(br.at(i), id.at(i));
-    bch_vec.emplace_back(bchptr);
-    id_vec.emplace_back(br.at(i)->GetId());
+  return values_.back();
+}
+
+void AnalysisEntry::ReleaseRows() {
+  for (auto& row : values_) {
+    spare_rows_.emplace_back(std::move(row));
   }
-  double result = var.GetValue(bch_vec, id_vec);
-  for (auto& bv : bch_vec) {
-    delete bv;
+  values_.clear();
+}
+
+/**
+* @brief FillRow evaluates Variables for the current channels and appends the result to values_ and weights_
+*/
+void AnalysisEntry::FillRow(size_t i_channel) {
+  auto& row = NewRow();
+  for (size_t i_var = 0; i_var < vars_.size(); ++i_var) {
+    const auto* cached = cached_values_[i_var];
+    row[i_var] = cached != nullptr ? (*cached)[i_channel] : vars_[i_var].GetBoundValue(channel_ptrs_);
+  }//variables
+  weights_.emplace_back(var4weight_.GetBoundValue(channel_ptrs_));
+}
+
+/**
+* @brief FillColumn evaluates Variable for all channels of the branch i_branch. Variables of this branch
+* only are evaluated at once with Variable::GetValues(), others channel by channel
+*/
+const std::vector<double>& AnalysisEntry::FillColumn(const Variable& var, size_t i_branch, size_t n_channels) {
+  column_.resize(n_channels);
+  if (var.GetNumberOfBranches() == 1 && var.GetFields().at(0).GetBranchId() == branch_ids_[i_branch]) {
+    var.GetValues(*branches_[i_branch].first, 0, n_channels, column_.data());
+  } else {
+    for (size_t i_channel = 0; i_channel < n_channels; ++i_channel) {
+      SetChannel(i_branch, i_channel);
+      column_[i_channel] = var.GetBoundValue(channel_ptrs_);
+    }
   }
-  return result;
+  return column_;
 }
 
-double AnalysisEntry::FillVariable(const Variable& var, const Branch& br1, int ch1, const Branch& br2, int ch2) {
-  Branch* br1_ptr = new Branch(std::move(br1));
-  Branch* br2_ptr = new Branch(std::move(br2));
-  std::vector<const Branch*> br_vec{br1_ptr, br2_ptr};
-  std::vector<int> ch_vec{ch1, ch2};
-  double result = FillVariable(var, br_vec, ch_vec);
-  delete br1_ptr;
-  delete br2_ptr;
-  return result;
+/**
+* @brief PrepareCachedColumns sets cached_values_ for Variables kept in ColumnCache. Columns which are not
+* in the cache yet are computed for all channels, regardless of cuts, and passed to the cache
+*/
+void AnalysisEntry::PrepareCachedColumns(size_t i_branch, size_t n_channels) {
+  for (size_t i_var = 0; i_var < vars_.size(); ++i_var) {
+    if (cache_columns_[i_var] < 0) continue;
+    const auto i_column = static_cast<size_t>(cache_columns_[i_var]);
+    if (!cache_->IsCached(i_column) && cache_->GetColumn(i_column).size() != n_channels) {// not yet filled by other entries
+      const auto& column = FillColumn(vars_[i_var], i_branch, n_channels);
+      cache_->Column(i_column).assign(column.begin(), column.end());
+    }
+    const auto& column = cache_->GetColumn(i_column);
+    if (column.size() != n_channels) {
+      throw std::runtime_error("AnalysisEntry::PrepareCachedColumns - cached " + vars_[i_var].GetName() + " has " + std::to_string(column.size()) + " channels instead of " + std::to_string(n_channels));
+    }
+    cached_values_[i_var] = &column;
+  }
 }
 
 void AnalysisEntry::FillValues() {
-  values_.clear();
+  ReleaseRows();
   weights_.clear();
+  for (auto& ehi : eve_header_indices_) {
+    SetChannel(ehi, 0);
+  }
   if (non_eve_header_indices_.size() == 0) {
     FillFromEveHeaders();
   } else if (non_eve_header_indices_.size() == 1) {
@@ -110,29 +194,8 @@ void AnalysisEntry::FillValues() {
 * @brief FillFromEveHeaders populates Variables from event headers only
 */
 void AnalysisEntry::FillFromEveHeaders() {
-  std::vector<const Branch*> br_vec;
-  std::vector<Cuts*> cuts_vec;
-  std::vector<int> id_vec;
-  br_vec.reserve(branches_.size());
-  cuts_vec.reserve(branches_.size());
-  id_vec.reserve(branches_.size());
-  for (auto& br : branches_) {
-    br_vec.emplace_back(br.first);
-    cuts_vec.emplace_back(br.second);
-    id_vec.emplace_back(0);
-  }
-
-  values_.reserve(1);
-  weights_.reserve(1);
-  if (!ApplyCutOnBranches(br_vec, cuts_vec, id_vec)) return;
-  std::vector<double> temp_vars(vars_.size());
-  short i_var{0};
-  for (const auto& var : vars_) {
-    temp_vars[i_var] = FillVariable(var, br_vec, id_vec);
-    i_var++;
-  }//variables
-  values_.emplace_back(temp_vars);
-  weights_.emplace_back(FillVariable(var4weight_, br_vec, id_vec));
+  if (!ApplyCuts()) return;
+  FillRow();
 }
 
 /**
@@ -140,35 +203,42 @@ void AnalysisEntry::FillFromEveHeaders() {
 * and any number of event headers.
 */
 void AnalysisEntry::FillFromOneChannalizedBranch() {
-  const auto n_channels = branches_.at(non_eve_header_indices_.at(0)).first->size();
-  values_.reserve(n_channels);
-  weights_.reserve(n_channels);
-
-  std::vector<const Branch*> br_vec;
-  std::vector<Cuts*> cuts_vec;
-  std::vector<int> id_vec;
-  br_vec.reserve(branches_.size());
-  cuts_vec.reserve(branches_.size());
-  id_vec.resize(branches_.size());
-  for (const auto& br : branches_) {
-    br_vec.emplace_back(br.first);
-    cuts_vec.emplace_back(br.second);
+  const auto i_branch = non_eve_header_indices_.at(0);
+  const auto n_channels = branches_.at(i_branch).first->size();
+  if (cache_ != nullptr) {
+    PrepareCachedColumns(i_branch, n_channels);
   }
-  for (auto& ehi : eve_header_indices_) {
-    id_vec.at(ehi) = 0;
+
+  if (!has_cuts_) {// all channels are accepted, fill values variable by variable
+    for (size_t i_channel = 0; i_channel < n_channels; ++i_channel) {
+      NewRow();
+    }
+    for (size_t i_var = 0; i_var < vars_.size(); ++i_var) {
+      const auto& column = cached_values_[i_var] != nullptr ? *cached_values_[i_var] : FillColumn(vars_[i_var], i_branch, n_channels);
+      for (size_t i_channel = 0; i_channel < n_channels; ++i_channel) {
+        values_[i_channel][i_var] = column[i_channel];
+      }
+    }
+    const auto& column = FillColumn(var4weight_, i_branch, n_channels);
+    weights_.assign(column.begin(), column.end());
+    return;
+  }
+
+  if (is_batch_cuts_) {
+    if (!ApplyEveHeaderCuts()) return;
+    ApplyCutsBatch(i_branch);
+    for (size_t i_channel = 0; i_channel < n_channels; ++i_channel) {
+      if (!mask_[i_channel]) continue;
+      SetChannel(i_branch, i_channel);
+      FillRow(i_channel);
+    }// channels
+    return;
   }
 
   for (size_t i_channel = 0; i_channel < n_channels; ++i_channel) {
-    id_vec.at(non_eve_header_indices_.at(0)) = i_channel;
-    if (!ApplyCutOnBranches(br_vec, cuts_vec, id_vec)) continue;
-    std::vector<double> temp_vars(vars_.size());
-    short i_var{0};
-    for (const auto& var : vars_) {
-      temp_vars[i_var] = FillVariable(var, br_vec, id_vec);
-      i_var++;
-    }//variables
-    values_.emplace_back(temp_vars);
-    weights_.emplace_back(FillVariable(var4weight_, br_vec, id_vec));
+    SetChannel(i_branch, i_channel);
+    if (!ApplyCuts()) continue;
+    FillRow(i_channel);
   }// channels
 }
 
@@ -181,37 +251,14 @@ void AnalysisEntry::FillFromTwoChannalizedBranches() {
   if (matching_ == nullptr) {
     throw std::runtime_error("AnalysisEntry::FillFromTwoChannalizedBranches() - Matching between non-EventHeader branches must be set");
   }
+  const auto i_branch1 = non_eve_header_indices_.at(0);
+  const auto i_branch2 = non_eve_header_indices_.at(1);
 
-  values_.reserve(matching_->GetMatches().size());
-  weights_.reserve(matching_->GetMatches().size());
-
-  std::vector<const Branch*> br_vec;
-  std::vector<Cuts*> cuts_vec;
-  std::vector<int> id_vec;
-  br_vec.reserve(branches_.size());
-  cuts_vec.reserve(branches_.size());
-  id_vec.resize(branches_.size());
-  for (const auto& br : branches_) {
-    br_vec.emplace_back(br.first);
-    cuts_vec.emplace_back(br.second);
-  }
-  for (auto& ehi : eve_header_indices_) {
-    id_vec.at(ehi) = 0;
-  }
-
-  for (auto match : matching_->GetMatches(is_inverted_matching_)) {
-    id_vec.at(non_eve_header_indices_.at(0)) = match.first;
-    id_vec.at(non_eve_header_indices_.at(1)) = match.second;
-
-    if (!ApplyCutOnBranches(br_vec, cuts_vec, id_vec)) continue;
-    std::vector<double> temp_vars(vars_.size());
-    short i_var{0};
-    for (const auto& var : vars_) {
-      temp_vars[i_var] = FillVariable(var, br_vec, id_vec);
-      i_var++;
-    }//variables
-    values_.emplace_back(temp_vars);
-    weights_.emplace_back(FillVariable(var4weight_, br_vec, id_vec));
+  for (const auto& match : matching_->GetMatchPairs(is_inverted_matching_)) {
+    SetChannel(i_branch1, match.first);
+    SetChannel(i_branch2, match.second);
+    if (!ApplyCuts()) continue;
+    FillRow();
   }// channels
 }
 
@@ -256,6 +303,65 @@ void AnalysisEntry::Init(const Configuration& conf, const std::map<std::string,
     SetIsInvertedMatching(match_info.second);
     SetMatching((Matching*) matches.find(match_info.first)->second);
   }
+  InitChannels();
+  BindToBranches();
+  InitColumnCache();
+}
+
+void AnalysisEntry::InitChannels() {
+  channels_.clear();
+  channel_ptrs_.clear();
+  branch_ids_.clear();
+  channels_.reserve(branches_.size());
+  for (const auto& br : branches_) {
+    BranchChannel channel;
+    channel.branch_ = br.first;
+    channels_.emplace_back(std::move(channel));
+    branch_ids_.emplace_back(br.first->GetConfig().GetId());
+  }
+  for (const auto& channel : channels_) {
+    channel_ptrs_.emplace_back(&channel);
+  }
+}
+
+void AnalysisEntry::BindToBranches() {
+  for (auto& var : vars_) {
+    var.Bind(branch_ids_);
+  }
+  var4weight_.Bind(branch_ids_);
+  has_cuts_ = cuts_ != nullptr;
+  if (cuts_) {
+    bound_cuts_ = *cuts_;
+    bound_cuts_.Bind(branch_ids_);
+  }
+  for (const auto& br : branches_) {
+    has_cuts_ = has_cuts_ || br.second != nullptr;
+  }
+
+  is_batch_cuts_ = false;
+  if (non_eve_header_indices_.size() == 1) {
+    const auto& br = branches_.at(non_eve_header_indices_.at(0));
+    const auto& name = br.first->GetBranchName();
+    is_batch_cuts_ = (br.second == nullptr || br.second->IsBatchable(name)) && (cuts_ == nullptr || cuts_->IsBatchable(name));
+  }
+}
+
+/**
+* @brief InitColumnCache registers in cache_ Variables which depend on the channalized branch only.
+* Variables with a lambda without version (see Variable::SetVersion()) are always computed
+*/
+void AnalysisEntry::InitColumnCache() {
+  cache_columns_.assign(vars_.size(), -1);
+  cached_values_.assign(vars_.size(), nullptr);
+  if (cache_ == nullptr || non_eve_header_indices_.size() != 1) return;
+  const auto branch_id = branch_ids_.at(non_eve_header_indices_.at(0));
+  for (size_t i_var = 0; i_var < vars_.size(); ++i_var) {
+    const auto& var = vars_[i_var];
+    if (var.GetNumberOfBranches() == 1 && !var.GetFields().empty() && var.GetFields().at(0).GetBranchId() == branch_id
+        && var.IsDefinitionComplete()) {
+      cache_columns_[i_var] = static_cast<int>(cache_->AddColumn(var));
+    }
+  }
 }
 
 size_t AnalysisEntry::AddVariable(const Variable& var) {
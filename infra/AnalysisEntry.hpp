@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "Branch.hpp"
+#include "ColumnCache.hpp"
 #include "Cuts.hpp"
 #include "Matching.hpp"
 #include "Variable.hpp"
@@ -24,6 +25,12 @@ class AnalysisEntry {
 
  public:
   AnalysisEntry() = default;
+  /**
+   * @brief Branches are copied, so that each AnalysisEntry owns its own. If other is initialized, channels are rebuilt
+   * to point to the new copies
+   */
+  AnalysisEntry(const AnalysisEntry& other);
+  AnalysisEntry& operator=(const AnalysisEntry& other);
   virtual ~AnalysisEntry();
 
   explicit AnalysisEntry(std::vector<Variable> vars, Cuts* cuts = nullptr, Variable vars4weight = {}) : vars_(std::move(vars)),
@@ -50,26 +57,39 @@ class AnalysisEntry {
   ANALYSISTREE_ATTR_NODISCARD Variable& VariableForWeight() { return var4weight_; }
 
   void AddBranch(const Branch& branch, Cuts* cuts = nullptr);
+  void SetCuts(Cuts* cuts) { cuts_ = cuts; }
   void SetMatching(Matching* matching) { matching_ = matching; }
   void SetIsInvertedMatching(bool is_inverted_matching) { is_inverted_matching_ = is_inverted_matching; }
+  /**
+   * @brief Values of Variables of one channalized branch are taken from cache instead of being computed,
+   * see ColumnCache. Should be called before Init(), columns are registered in Init()
+   */
+  void SetColumnCache(ColumnCache* cache) { cache_ = cache; }
   void FillBranchNames();
 
  private:
   void FillFromEveHeaders();
   void FillFromOneChannalizedBranch();
   void FillFromTwoChannalizedBranches();
-  ANALYSISTREE_ATTR_NODISCARD bool ApplyCutOnBranch(const Branch& br, Cuts* cuts, int i_channel) const;
-  ANALYSISTREE_ATTR_NODISCARD bool ApplyCutOnBranches(std::vector<const Branch*>& br, std::vector<Cuts*>& cuts, std::vector<int>& ch) const;
-  [[deprecated]] ANALYSISTREE_ATTR_NODISCARD bool ApplyCutOnBranches(const Branch& br1, Cuts* cuts1, int ch1, const Branch& br2, Cuts* cuts2, int ch2) const;
-  static double FillVariable(const Variable& var, std::vector<const Branch*>& br, std::vector<int>& id);
-  [[deprecated]] static double FillVariable(const Variable& var, const Branch& br1, int ch1, const Branch& br2, int ch2);
+  void InitChannels();
+  void BindToBranches();
+  void SetChannel(size_t i_branch, size_t i_channel) { channels_[i_branch].UpdateChannel(i_channel); }
+  ANALYSISTREE_ATTR_NODISCARD bool ApplyCuts();
+  ANALYSISTREE_ATTR_NODISCARD bool ApplyEveHeaderCuts();
+  void ApplyCutsBatch(size_t i_branch);
+  void FillRow(size_t i_channel = 0);
+  const array1D& FillColumn(const Variable& var, size_t i_branch, size_t n_channels);
+  void InitColumnCache();
+  void PrepareCachedColumns(size_t i_branch, size_t n_channels);
+  std::vector<double>& NewRow();
+  void ReleaseRows();
 
   std::vector<Variable> vars_{};
   Variable var4weight_{};
   Cuts* cuts_{nullptr};///< non-owning
 
   std::set<std::string> branch_names_{};
-  std::vector<std::pair<const Branch*, Cuts*>> branches_{};///< non-owning pointers
+  std::vector<std::pair<const Branch*, Cuts*>> branches_{};///< owns copies of Branches, Cuts are non-owning
 
   std::vector<int> eve_header_indices_{};
   std::vector<int> non_eve_header_indices_{};
@@ -80,6 +100,24 @@ class AnalysisEntry {
   array2D values_{}; ///< channels<variables>
   array1D weights_{};///< channels<weights>
 
+  /**
+   * Scratch state prepared in Init(), so that FillValues() does not allocate in steady state
+   */
+  std::vector<BranchChannel> channels_{};          //! one per branch, pointing to the current channel
+  std::vector<const BranchChannel*> channel_ptrs_{};//! pointers to channels_
+  std::vector<size_t> branch_ids_{};               //!
+  array2D spare_rows_{};                           //! rows of values_ from previous events, kept for reuse
+  array1D column_{};                               //! values of one Variable for all channels, also used by batch cuts
+  array1D cut_values_{};                           //! arguments of the cuts, see SimpleCut::Apply()
+  Cuts bound_cuts_{};                              //! copy of cuts_ bound to branch_ids_
+  bool has_cuts_{false};                           //!
+  bool is_batch_cuts_{false};                      //! all cuts of the channalized branch are evaluated with Cuts::ApplyBatch()
+  std::vector<char> mask_{};                       //! channels passing the cuts, see ApplyCutsBatch()
+  std::vector<char> cuts_mask_{};                  //!
+  ColumnCache* cache_{nullptr};                    //! non-owning
+  std::vector<int> cache_columns_{};               //! column of each Variable in cache_, -1 if not cached
+  std::vector<const array1D*> cached_values_{};    //! values of all channels of the current event, per Variable
+
   ClassDef(AnalysisEntry, 1);
 };
 
@@ -0,0 +1,61 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_ANALYSISENTRY_TEST_CPP_
+#define ANALYSISTREE_INFRA_ANALYSISENTRY_TEST_CPP_
+
+#include <gtest/gtest.h>
+
+#include "AnalysisEntry.hpp"
+
+namespace {
+
+using namespace AnalysisTree;
+
+TEST(AnalysisEntry, FillValuesRepeated) {
+  const int n_tracks = 1000;
+  const int n_vars = 30;
+  const int n_events = 10;
+
+  BranchConfig config("RecTracks", DetType::kTrack);
+  config.AddField<float>("chi2", "test field");
+  Configuration configuration;
+  configuration.AddBranchConfig(config);
+
+  auto* tracks = new TrackDetector(config.GetId());
+  for (int i = 0; i < n_tracks; ++i) {
+    auto& track = tracks->AddChannel(config);
+    track.SetMomentum(0.01f * i, 0.5f, 1.f);
+    track.SetField(0.1f * i, config.GetFieldId("chi2"));
+  }
+  Branch branch(config, tracks);
+
+  const std::vector<std::string> field_names{"px", "py", "pz", "pT", "phi", "eta", "p", "chi2"};
+  std::vector<Variable> vars;
+  for (int i = 0; i < n_vars; ++i) {
+    vars.emplace_back("RecTracks", field_names.at(i % field_names.size()));
+  }
+  Cuts cuts("cuts", {RangeCut("RecTracks.chi2", 0., 100.)});
+  Cuts branch_cuts("branch_cuts", {RangeCut("RecTracks.px", 0., 4.995)});
+  branch_cuts.Init(configuration);
+
+  AnalysisEntry entry(vars, &cuts);
+  entry.AddBranch(branch, &branch_cuts);
+  entry.Init(configuration, {});
+
+  entry.FillValues();
+  ASSERT_EQ(entry.GetValues().size(), 500);
+  ASSERT_EQ(entry.GetValues().at(0).size(), n_vars);
+
+  for (int i = 0; i < n_events; ++i) {// rows and scratch buffers are reused
+    entry.FillValues();
+    ASSERT_EQ(entry.GetValues().size(), 500);
+    ASSERT_EQ(entry.GetWeights().size(), 500);
+  }
+  EXPECT_FLOAT_EQ(entry.GetValues().at(10).at(0), 0.1f);
+  EXPECT_FLOAT_EQ(entry.GetValues().at(10).at(7), 1.f);
+}
+
+}// namespace
+
+#endif//ANALYSISTREE_INFRA_ANALYSISENTRY_TEST_CPP_
@@ -10,22 +10,57 @@ namespace AnalysisTree {
 
 void AnalysisTask::Init() {
   assert(!is_init_);
-  auto* chain = TaskManager::GetInstance()->GetChain();
+  auto* man = TaskManager::GetInstance();
+  auto* chain = man->GetChain();
+
+  if (!column_cache_name_.empty()) {
+    if (man->GetNThreads() > 1) {
+      throw std::runtime_error("AnalysisTask::Init - column cache is not supported in parallel event loop");
+    }
+    column_cache_ = std::make_shared<ColumnCache>(column_cache_name_);
+  }
 
   for (auto& var : entries_) {
     for (const auto& br : var.GetBranchNames()) {
       Cuts* branch_cut = cuts_map_.find(br) != cuts_map_.end() ? cuts_map_.find(br)->second : nullptr;
       var.AddBranch(chain->GetBranchObject(br), branch_cut);
     }
+    var.SetColumnCache(column_cache_.get());
     var.Init(*config_, chain->GetMatchPointers());
   }// vars
+  if (column_cache_ != nullptr) {
+    column_cache_->Init(*chain);
+  }
   is_init_ = true;
 }
 
 void AnalysisTask::Exec() {
+  if (column_cache_ != nullptr) {
+    column_cache_->SetEntry(TaskManager::GetInstance()->GetCurrentEntry());
+  }
   for (auto& var : entries_) {
     var.FillValues();
   }
+  if (column_cache_ != nullptr) {
+    column_cache_->Fill();
+  }
+}
+
+void AnalysisTask::Finish() {
+  if (column_cache_ != nullptr) {
+    column_cache_->Write();
+    column_cache_.reset();
+  }
+}
+
+void AnalysisTask::CopyCuts() {
+  Task::CopyCuts();
+  for (auto& cut : cuts_map_) {
+    cut.second = GetCutsCopy(cut.second);
+  }
+  for (auto& entry : entries_) {
+    entry.SetCuts(GetCutsCopy(entry.GetCuts()));
+  }
 }
 
 std::pair<int, std::vector<int>> AnalysisTask::AddEntry(const AnalysisEntry& vars) {
@@ -4,6 +4,7 @@
 #ifndef ANALYSISTREE_INFRA_ANALYSISTASK_HPP_
 #define ANALYSISTREE_INFRA_ANALYSISTASK_HPP_
 
+#include "memory"
 #include "vector"
 
 #include "AnalysisEntry.hpp"
@@ -30,7 +31,22 @@ class AnalysisTask : public Task {
 
   void Init() override;
   void Exec() override;
-  void Finish() override{};
+  void Finish() override;
+
+  /**
+   * @brief Enables ColumnCache in file filename: Variables of one channalized branch are read from the cache
+   * if they were computed in previous runs over the same input. The cache is updated only if the task
+   * processes all entries of the input, so the task should not have event cuts then.
+   * Variables with a lambda are cached only if Variable::SetVersion() is used.
+   * Not supported in parallel event loop
+   */
+  void SetColumnCache(std::string filename) { column_cache_name_ = std::move(filename); }
+
+  /**
+   * @brief Values are filled per event only, so AnalysisTask does not implement Clone(). Derived tasks which
+   * accumulate results may implement Clone() and Merge() to run in parallel event loop, cuts are copied here
+   */
+  void CopyCuts() override;
 
   ANALYSISTREE_ATTR_NODISCARD const array2D& GetValues(int i_var) const { return entries_.at(i_var).GetValues(); }
   ANALYSISTREE_ATTR_NODISCARD const array1D& GetWeights(int i_var) const { return entries_.at(i_var).GetWeights(); }
@@ -51,6 +67,8 @@ class AnalysisTask : public Task {
  protected:
   std::vector<AnalysisEntry> entries_{};
   std::map<std::string, Cuts*> cuts_map_{};
+  std::string column_cache_name_{};
+  std::shared_ptr<ColumnCache> column_cache_{nullptr};//!
 
   ClassDefOverride(AnalysisTask, 0);
 };
@@ -10,6 +10,7 @@
 #include "TaskManager.hpp"
 #include "ToyMC.hpp"
 
+#include <cstdio>
 #include <random>
 
 namespace {
@@ -114,5 +115,117 @@ TEST(AnalysisTask, Basics) {
   man->Finish();
 }
 
+TEST(AnalysisTask, ColumnCache) {
+  const int n_events = 200;
+  const std::string filelist = "fl_toy_mc_cache.txt";
+  const std::string cache_file = "column_cache.root";
+  std::remove(cache_file.c_str());
+
+  RunToyMC(n_events, filelist);
+
+  auto* man = TaskManager::GetInstance();
+  auto pt = Variable::FromExpression("sqrt(RecTracks.px^2 + RecTracks.py^2)");
+  Cuts eta_cut("eta_cut", {RangeCut({"RecTracks.eta"}, -1, 1)});
+
+  auto run = [&]() {
+    man->ClearTasks();
+    auto* task = new AnalysisTaskTest;
+    task->AddEntry(AnalysisEntry({pt}));
+    task->AddEntry(AnalysisEntry({pt}, &eta_cut));
+    task->SetColumnCache(cache_file);
+    man->AddTask(task);
+    man->Init({filelist}, {"tTree"});
+    man->Run(-1);
+    man->Finish();
+    man->ClearTasks();
+    auto result = task->GetEntriesTest();
+    delete task;
+    return result;
+  };
+  auto is_cached = [&]() {
+    Chain chain(std::vector<std::string>{filelist}, {"tTree"});
+    ColumnCache cache(cache_file);
+    cache.AddColumn(pt);
+    cache.Init(chain);
+    return cache.IsCached(0);
+  };
+
+  const auto computed = run();
+  ASSERT_TRUE(is_cached());
+  const auto cached = run();
+  ASSERT_EQ(computed.size(), cached.size());
+  for (size_t i = 0; i < computed.size(); ++i) {
+    EXPECT_EQ(computed[i].at(0).n_entries_, cached[i].at(0).n_entries_);
+    EXPECT_DOUBLE_EQ(computed[i].at(0).mean_, cached[i].at(0).mean_);
+    EXPECT_DOUBLE_EQ(computed[i].at(0).sigma_, cached[i].at(0).sigma_);
+  }
+  EXPECT_LT(cached.at(1).at(0).n_entries_, cached.at(0).at(0).n_entries_);// cuts are applied to cached values
+
+  RunToyMC(n_events, filelist);// new input, cached column is stale
+  ASSERT_FALSE(is_cached());
+  run();
+  ASSERT_TRUE(is_cached());
+
+  TFile file(cache_file.c_str(), "read");
+  int n_columns{0};
+  for (auto* key : *file.GetListOfKeys()) {
+    const std::string name = key->GetName();
+    n_columns += name.size() > 4 && name.substr(name.size() - 4) == "_key";
+  }
+  EXPECT_EQ(n_columns, 1);// column of the previous input is removed
+}
+
+TEST(AnalysisTask, ColumnCacheLambda) {
+  const int n_events = 100;
+  const std::string filelist = "fl_toy_mc_cache_lambda.txt";
+  const std::string cache_file = "column_cache_lambda.root";
+  std::remove(cache_file.c_str());
+
+  RunToyMC(n_events, filelist);
+
+  auto* man = TaskManager::GetInstance();
+  const std::vector<Field> fields{Field("RecTracks", "px")};
+  Variable px("px_scaled", fields, [](std::vector<double>& var) { return var[0]; });
+  Variable px_twice("px_scaled", fields, [](std::vector<double>& var) { return 2 * var[0]; });// lambda is changed
+
+  {
+    ColumnCache cache(cache_file);
+    EXPECT_ANY_THROW(cache.AddColumn(px));// same definition as px_twice without version
+  }
+  px.SetVersion("v1");
+  px_twice.SetVersion("v2");
+  ASSERT_NE(px.GetDefinition(), px_twice.GetDefinition());
+
+  auto run = [&](const Variable& var) {
+    man->ClearTasks();
+    auto* task = new AnalysisTaskTest;
+    task->AddEntry(AnalysisEntry({var}));
+    task->SetColumnCache(cache_file);
+    man->AddTask(task);
+    man->Init({filelist}, {"tTree"});
+    man->Run(-1);
+    man->Finish();
+    man->ClearTasks();
+    auto result = task->GetEntriesTest().at(0).at(0);
+    delete task;
+    return result;
+  };
+  auto is_cached = [&](const Variable& var) {
+    Chain chain(std::vector<std::string>{filelist}, {"tTree"});
+    ColumnCache cache(cache_file);
+    cache.AddColumn(var);
+    cache.Init(chain);
+    return cache.IsCached(0);
+  };
+
+  const auto computed = run(px);
+  ASSERT_TRUE(is_cached(px));
+  ASSERT_FALSE(is_cached(px_twice));// new version is computed again
+  const auto computed_twice = run(px_twice);
+  ASSERT_TRUE(is_cached(px_twice));
+  EXPECT_EQ(computed.n_entries_, computed_twice.n_entries_);
+  EXPECT_DOUBLE_EQ(2 * computed.mean_, computed_twice.mean_);
+}
+
 }// namespace
 #endif//ANALYSISTREE_INFRA_ANALYSISTASK_TEST_HPP_
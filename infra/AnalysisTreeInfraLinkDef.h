@@ -7,6 +7,7 @@
 #pragma link C++ class AnalysisTree::SimpleCut+;
 #pragma link C++ function AnalysisTree::RangeCut;
 #pragma link C++ function AnalysisTree::EqualsCut;
+#pragma link C++ function AnalysisTree::ExpressionCut;
 #pragma link C++ class AnalysisTree::Cuts+;
 
 #pragma link C++ class AnalysisTree::Variable;
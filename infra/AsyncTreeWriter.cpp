@@ -0,0 +1,168 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include "AsyncTreeWriter.hpp"
+
+#include "VariantMagic.hpp"
+
+#include <TTree.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace AnalysisTree {
+
+AsyncTreeWriter::AsyncTreeWriter(TTree* tree, size_t depth) : tree_(tree),
+                                                              depth_(std::max<size_t>(depth, 1)) {
+  if (tree_ == nullptr) {
+    throw std::runtime_error("AsyncTreeWriter - tree is nullptr");
+  }
+}
+
+AsyncTreeWriter::~AsyncTreeWriter() {
+  try {
+    Stop();
+  } catch (const std::exception& e) {
+    std::cout << "AsyncTreeWriter::~AsyncTreeWriter - " << e.what() << std::endl;
+  }
+  auto clear = [](Slot& slot) {
+    for (auto& branch : slot.branches) {
+      ANALYSISTREE_UTILS_VISIT(delete_object_struct(), branch.second);
+    }
+    for (auto& match : slot.matches) {
+      delete match.second;
+    }
+  };
+  clear(current_);
+  for (auto& slot : slots_) {
+    clear(slot);
+  }
+}
+
+void AsyncTreeWriter::AddBranch(const std::string& name, BranchPointer object) {
+  if (is_running_) {
+    throw std::runtime_error("AsyncTreeWriter::AddBranch - writer is already started");
+  }
+  branches_.emplace(name, object);
+}
+
+void AsyncTreeWriter::AddMatching(const std::string& name, Matching* object) {
+  if (is_running_) {
+    throw std::runtime_error("AsyncTreeWriter::AddMatching - writer is already started");
+  }
+  matches_.emplace(name, object);
+}
+
+void AsyncTreeWriter::Start() {
+  if (is_running_) return;
+
+  auto make_slot = [this](Slot& slot) {
+    for (const auto& branch : branches_) {
+      if (slot.branches.count(branch.first) == 0) {
+        slot.branches.emplace(branch.first, ANALYSISTREE_UTILS_VISIT(new_object_struct(), branch.second));
+      }
+    }
+    for (const auto& match : matches_) {
+      if (slot.matches.count(match.first) == 0) {
+        slot.matches.emplace(match.first, new Matching);
+      }
+    }
+  };
+  make_slot(current_);
+  slots_.resize(depth_);
+  for (auto& slot : slots_) {
+    make_slot(slot);
+  }
+  SetAddresses(current_.branches, current_.matches);
+
+  i_read_ = 0;
+  i_write_ = 0;
+  n_ready_ = 0;
+  is_stop_ = false;
+  error_ = nullptr;
+  is_running_ = true;
+  thread_ = std::thread(&AsyncTreeWriter::Write, this);
+}
+
+void AsyncTreeWriter::Fill() {
+  if (!is_running_) {
+    throw std::runtime_error("AsyncTreeWriter::Fill - writer is not started");
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_free_.wait(lock, [this] { return error_ || n_ready_ < slots_.size(); });
+    if (error_) std::rethrow_exception(error_);
+  }
+  // slot is not visible to the writer thread until n_ready_ is increased
+  auto& slot = slots_.at(i_write_);
+  for (const auto& branch : branches_) {
+    ANALYSISTREE_UTILS_VISIT(copy_object_struct(slot.branches.at(branch.first)), branch.second);
+  }
+  for (const auto& match : matches_) {
+    *slot.matches.at(match.first) = *match.second;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    i_write_ = (i_write_ + 1) % slots_.size();
+    ++n_ready_;
+  }
+  cv_ready_.notify_one();
+}
+
+void AsyncTreeWriter::Write() {
+  try {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_ready_.wait(lock, [this] { return is_stop_ || n_ready_ > 0; });
+        if (n_ready_ == 0) return;// stopped and all entries are written
+      }
+      auto& slot = slots_.at(i_read_);
+      for (auto& branch : current_.branches) {
+        ANALYSISTREE_UTILS_VISIT(swap_content_struct(slot.branches.at(branch.first)), branch.second);
+      }
+      for (auto& match : current_.matches) {
+        std::swap(*match.second, *slot.matches.at(match.first));
+      }
+      tree_->Fill();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        i_read_ = (i_read_ + 1) % slots_.size();
+        --n_ready_;
+      }
+      cv_free_.notify_one();
+    }
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = std::current_exception();
+    }
+    cv_free_.notify_all();
+  }
+}
+
+void AsyncTreeWriter::Stop() {
+  if (!is_running_) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stop_ = true;
+  }
+  cv_ready_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  is_running_ = false;
+  SetAddresses(branches_, matches_);
+  if (error_) std::rethrow_exception(error_);
+}
+
+void AsyncTreeWriter::SetAddresses(std::map<std::string, BranchPointer>& branches, std::map<std::string, Matching*>& matches) {
+  for (auto& branch : branches) {
+    ANALYSISTREE_UTILS_VISIT(set_branch_address_struct(tree_, branch.first), branch.second);
+  }
+  for (auto& match : matches) {
+    tree_->SetBranchAddress(match.first.c_str(), &match.second);
+  }
+}
+
+}// namespace AnalysisTree
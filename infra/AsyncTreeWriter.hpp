@@ -0,0 +1,97 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_ASYNCTREEWRITER_HPP_
+#define ANALYSISTREE_INFRA_ASYNCTREEWRITER_HPP_
+
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Matching.hpp"
+#include "Utils.hpp"
+
+class TTree;
+
+namespace AnalysisTree {
+
+/**
+ * @brief AsyncTreeWriter fills the output tree in a background thread, so that serialization and compression
+ * do not stall the event loop. Fill() copies the registered branch and matching objects into a free slot of a ring;
+ * the writer thread moves slots, in the order of Fill() calls, into its own set of objects connected to the tree
+ * and calls TTree::Fill(). Memory use is bounded by the number of slots.
+ * After Start() the tree should not be used by other threads until Stop().
+ */
+class AsyncTreeWriter {
+
+ public:
+  /**
+   * @param tree output tree
+   * @param depth number of snapshots which can wait in the queue
+   */
+  AsyncTreeWriter(TTree* tree, size_t depth);
+  AsyncTreeWriter(const AsyncTreeWriter&) = delete;
+  AsyncTreeWriter& operator=(const AsyncTreeWriter&) = delete;
+  virtual ~AsyncTreeWriter();
+
+  /**
+   * @brief Registers an object of the tree. Should be called before Start()
+   * @param name name of the branch in the tree
+   * @param object object filled by the tasks, its content is copied in Fill()
+   */
+  void AddBranch(const std::string& name, BranchPointer object);
+  void AddMatching(const std::string& name, Matching* object);
+
+  /**
+   * @brief Connects the tree to objects of the writer and starts the writer thread
+   */
+  void Start();
+
+  /**
+   * @brief Blocks until a slot is free, copies the registered objects into it and queues it for filling
+   */
+  void Fill();
+
+  /**
+   * @brief Waits until all queued entries are filled and stops the writer thread.
+   * Addresses of the tree are set back to the registered objects
+   */
+  void Stop();
+
+  ANALYSISTREE_ATTR_NODISCARD size_t GetDepth() const { return slots_.size(); }
+
+ private:
+  struct Slot {
+    std::map<std::string, BranchPointer> branches{};
+    std::map<std::string, Matching*> matches{};
+  };
+
+  void Write();
+  void SetAddresses(std::map<std::string, BranchPointer>& branches, std::map<std::string, Matching*>& matches);
+
+  TTree* tree_{nullptr};
+  size_t depth_{1};
+  std::map<std::string, BranchPointer> branches_{};///< registered objects, not owned
+  std::map<std::string, Matching*> matches_{};
+  Slot current_{};///< objects connected to the tree while writer runs
+  std::vector<Slot> slots_{};
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_ready_;
+  std::condition_variable cv_free_;
+  size_t i_read_{0};
+  size_t i_write_{0};
+  size_t n_ready_{0};
+  bool is_stop_{false};
+  bool is_running_{false};
+  std::exception_ptr error_{nullptr};
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_INFRA_ASYNCTREEWRITER_HPP_
@@ -18,31 +18,31 @@
 using namespace AnalysisTree;
 
 void Branch::InitDataPtr() {
-  switch (config_.GetType()) {
+  switch (config_->GetType()) {
     case DetType::kParticle: {
-      data_ = new Particles(config_.GetId());
+      data_ = new Particles(config_->GetId());
       break;
     }
     case DetType::kTrack: {
-      data_ = new TrackDetector(config_.GetId());
+      data_ = new TrackDetector(config_->GetId());
       break;
     }
     case DetType::kHit: {
-      data_ = new HitDetector(config_.GetId());
+      data_ = new HitDetector(config_->GetId());
       break;
     }
     case DetType::kModule: {
-      data_ = new ModuleDetector(config_.GetId());
+      data_ = new ModuleDetector(config_->GetId());
       break;
     }
     case DetType::kEventHeader: {
-      auto temp = new EventHeader(config_.GetId());
-      temp->Init(config_);
+      auto temp = new EventHeader(config_->GetId());
+      temp->Init(*config_);
       data_ = temp;
       break;
     }
     case DetType::kGeneric: {
-      data_ = new GenericDetector(config_.GetId());
+      data_ = new GenericDetector(config_->GetId());
       break;
     }
     default: throw std::runtime_error("Branch type is not known!");
@@ -53,6 +53,11 @@ size_t AnalysisTree::Branch::size() const {
   return ANALYSISTREE_UTILS_VISIT(get_n_channels_struct(), data_);
 }
 
+void Branch::GetFieldValues(const Field& field, size_t first, size_t n, double* out) const {
+  assert(field.IsInitialized());
+  ANALYSISTREE_UTILS_VISIT(get_field_values_struct(field, kinematics_, first, n, out), data_);
+}
+
 Field Branch::NewVariable(const std::string& field_name, const std::string& title, AnalysisTree::Types type) {
   if (field_name.empty()) {
     throw std::runtime_error("Field name cannot be empty");
@@ -60,7 +65,7 @@ Field Branch::NewVariable(const std::string& field_name, const std::string& titl
   if (type == AnalysisTree::Types::kNumberOfTypes) {
     throw std::runtime_error("Type of the field cannot be kNumberOfTypes");
   }
-  if (config_.HasField(field_name)) {
+  if (config_->HasField(field_name)) {
     throw std::runtime_error("Field of name '" + field_name + "' already exists in the config");
   }
 
@@ -68,34 +73,36 @@ Field Branch::NewVariable(const std::string& field_name, const std::string& titl
   CheckMutable(true);
   using AnalysisTree::Types;
 
+  auto config = std::make_shared<BranchConfig>(*config_);// shared config is not modified, it is replaced
   switch (type) {
     case Types::kFloat: {
-      config_.template AddField<float>(field_name, title);
+      config->template AddField<float>(field_name, title);
       break;
     }
     case Types::kInteger: {
-      config_.template AddField<int>(field_name, title);
+      config->template AddField<int>(field_name, title);
       break;
     }
     case Types::kBool: {
-      config_.template AddField<bool>(field_name, title);
+      config->template AddField<bool>(field_name, title);
       break;
     }
     default: assert(false);
   }
+  config_ = std::move(config);
 
   UpdateConfigHash();
 
   /* Init EventHeader */
-  if (config_.GetType() == AnalysisTree::DetType::kEventHeader) {
-    ANALYSISTREE_UTILS_GET<AnalysisTree::EventHeader*>(data_)->Init(config_);
+  if (config_->GetType() == AnalysisTree::DetType::kEventHeader) {
+    ANALYSISTREE_UTILS_GET<AnalysisTree::EventHeader*>(data_)->Init(*config_);
   }
 
   AnalysisTree::Field v;
   v.field_ = field_name;
   v.parent_branch_ = this;
-  v.field_id_ = config_.GetFieldId(field_name);
-  v.field_type_ = config_.GetFieldType(field_name);
+  v.field_id_ = config_->GetFieldId(field_name);
+  v.field_type_ = config_->GetFieldType(field_name);
   v.is_init_ = true;
   return v;
 }
@@ -109,7 +116,7 @@ void Branch::CloneVariables(const AnalysisTree::BranchConfig& other) {
   auto import_fields_from_map = [this](const std::map<std::string, ConfigElement>& map, AnalysisTree::Types type) {
     for (auto& element : map) {
       auto field_name = element.first;
-      if (config_.HasField(field_name)) {
+      if (config_->HasField(field_name)) {
         std::cout << "Field '" << field_name << "' already exists" << std::endl;
         continue;
       }
@@ -124,7 +131,7 @@ void Branch::CloneVariables(const AnalysisTree::BranchConfig& other) {
 
 BranchChannel Branch::NewChannel() {
   CheckMutable(true);
-  ANALYSISTREE_UTILS_VISIT(new_channel_struct(&(this->config_)), data_);
+  ANALYSISTREE_UTILS_VISIT(new_channel_struct(config_.get()), data_);
   Freeze();
   return BranchChannel(this, size() - 1);
 }
@@ -188,11 +195,11 @@ void Branch::CreateMapping(const Branch* other, std::string branch_name_prefix)
       {AnalysisTree::Types::kInteger, "integer"},
       {AnalysisTree::Types::kBool, "bool"}};
 
-  std::cout << "New cached mapping " << other->config_.GetName() << " --> " << config_.GetName() << std::endl;
+  std::cout << "New cached mapping " << other->config_->GetName() << " --> " << config_->GetName() << std::endl;
   FieldsMapping fields_mapping;
   for (auto& field_name_other : other->GetFieldNames()) {
     std::string field_name_target = branch_name_prefix + field_name_other;
-    if (!config_.HasField(field_name_target)) { continue; }
+    if (!config_->HasField(field_name_target)) { continue; }
     fields_mapping.field_pairs.emplace_back(other->GetField(field_name_other), GetField(field_name_target));
     std::cout << "\t" << field_name_other
               << "\t(" << types_map.at(other->GetField(field_name_other).GetFieldType()) << " ---> "
@@ -202,7 +209,7 @@ void Branch::CreateMapping(const Branch* other, std::string branch_name_prefix)
 }
 
 void Branch::UpdateConfigHash() {
-  config_hash_ = Impl::BranchConfigHasher(config_);
+  config_hash_ = Impl::BranchConfigHasher(*config_);
 }
 
 std::vector<std::string> Branch::GetFieldNames() const {
@@ -212,9 +219,9 @@ std::vector<std::string> Branch::GetFieldNames() const {
       result.push_back(element.first);
     }
   };
-  fill_vector_from_map(config_.GetMap<float>());
-  fill_vector_from_map(config_.GetMap<int>());
-  fill_vector_from_map(config_.GetMap<bool>());
+  fill_vector_from_map(config_->GetMap<float>());
+  fill_vector_from_map(config_->GetMap<int>());
+  fill_vector_from_map(config_->GetMap<bool>());
   return result;
 }
 
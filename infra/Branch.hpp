@@ -6,6 +6,7 @@
 
 #include <cassert>
 #include <map>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -20,6 +21,11 @@ class TTree;
 
 namespace AnalysisTree {
 
+/**
+ * @brief Handle of a branch object with its BranchConfig. The config is immutable and shared between copies
+ * of the handle together with its hash, so copies are cheap. Adding fields with NewVariable() replaces the config
+ * of this handle only
+ */
 class Branch {
  public:
   /* c-tors */
@@ -29,20 +35,28 @@ class Branch {
   Branch& operator=(Branch&&) = default;
   Branch& operator=(const Branch&) = default;
 
-  explicit Branch(BranchConfig config) : config_(std::move(config)) {
+  explicit Branch(BranchConfig config) : config_(std::make_shared<const BranchConfig>(std::move(config))) {
     InitDataPtr();
     UpdateConfigHash();
   }
 
   template<class T>
-  Branch(BranchConfig config, T* data) : config_(std::move(config)), data_(data) {
+  Branch(BranchConfig config, T* data) : config_(std::make_shared<const BranchConfig>(std::move(config))), data_(data) {
     UpdateConfigHash();
   }
 
-  Branch(BranchConfig config, BranchPointer ptr) : config_(std::move(config)), data_(std::move(ptr)) {
+  Branch(BranchConfig config, BranchPointer ptr) : config_(std::make_shared<const BranchConfig>(std::move(config))), data_(std::move(ptr)) {
     UpdateConfigHash();
   }
 
+  /**
+   * @brief Handle of ptr sharing config (and its hash) with other, no copy of BranchConfig is made
+   */
+  Branch(const Branch& other, BranchPointer ptr) : Branch(other) {
+    data_ = std::move(ptr);
+    kinematics_ = nullptr;// kinematics of other belongs to its data
+  }
+
   ~Branch();
 
   struct FieldsMapping {
@@ -50,9 +64,10 @@ class Branch {
   };
 
   /* Accessors to branch' main parameters, used very often */
-  [[nodiscard]] std::string GetBranchName() const { return config_.GetName(); }
-  [[nodiscard]] DetType GetBranchType() const { return config_.GetType(); }
-  [[nodiscard]] const BranchConfig& GetConfig() const { return config_; }
+  [[nodiscard]] std::string GetBranchName() const { return config_->GetName(); }
+  [[nodiscard]] DetType GetBranchType() const { return config_->GetType(); }
+  [[nodiscard]] const BranchConfig& GetConfig() const { return *config_; }
+  [[nodiscard]] std::size_t GetConfigHash() const { return config_hash_; }
 
   void InitDataPtr();
 
@@ -71,6 +86,18 @@ class Branch {
 
   std::vector<std::string> GetFieldNames() const;
 
+  /**
+   * @brief Reads field values of channels [first, first + n) into out.
+   * pT, p, phi, eta (and energy and rapidity of particles) are read from KinematicsColumns if they are set
+   */
+  void GetFieldValues(const Field& field, size_t first, size_t n, double* out) const;
+
+  /**
+   * @brief Sets kinematics of this branch, kept by the owner (Chain). Not owned
+   */
+  void SetKinematics(const KinematicsColumns* kinematics) { kinematics_ = kinematics; }
+  [[nodiscard]] const KinematicsColumns* GetKinematics() const { return kinematics_; }
+
   [[nodiscard]] size_t GetId() const {
     return ANALYSISTREE_UTILS_VISIT(get_id_struct(), data_);
   }
@@ -80,17 +107,18 @@ class Branch {
   [[nodiscard]] T& GetDataRaw() { return ANALYSISTREE_UTILS_GET<T>(data_); }
 
   [[nodiscard]] Field GetField(std::string field_name) const {
-    Field field(config_.GetName(), std::move(field_name));
-    field.Init(config_);
+    Field field(config_->GetName(), std::move(field_name));
+    field.Init(*config_);
     return field;
   }
 
  private:
-  AnalysisTree::BranchConfig config_;
+  std::shared_ptr<const BranchConfig> config_{std::make_shared<const BranchConfig>()};
   BranchPointer data_;/// owns object
   bool is_mutable_{false};
   bool is_frozen_{false};
   std::size_t config_hash_{0};
+  const KinematicsColumns* kinematics_{nullptr};
 
  public:
   AnalysisTree::Configuration* parent_config{nullptr};
@@ -104,14 +132,14 @@ class Branch {
   inline void CheckFrozen(bool expected = true) const {
     if (is_frozen_ != expected) {
       const std::string prefix = expected ? "un" : "";
-      const std::string message = "Branch " + config_.GetName() + " is " + prefix + "frozen while the opposite was expected";
+      const std::string message = "Branch " + config_->GetName() + " is " + prefix + "frozen while the opposite was expected";
       throw std::runtime_error(message);
     }
   }
   inline void CheckMutable(bool expected = true) const {
     if (is_mutable_ != expected) {
       const std::string prefix = expected ? "im" : "";
-      const std::string message = "Branch " + config_.GetName() + " is " + prefix + "mutable while the opposite was expected";
+      const std::string message = "Branch " + config_->GetName() + " is " + prefix + "mutable while the opposite was expected";
       throw std::runtime_error(message);
     }
   }
@@ -152,7 +180,7 @@ class Branch {
 
   [[nodiscard]] AnalysisTree::ShortInt_t Hash() const {
     const auto hasher = std::hash<std::string>();
-    return AnalysisTree::ShortInt_t(hasher(config_.GetName()));
+    return AnalysisTree::ShortInt_t(hasher(config_->GetName()));
   }
 
  private:
@@ -85,5 +85,32 @@ TEST(Branch, WriteValue) {
   EXPECT_FLOAT_EQ(particle->GetPz(), 0.5);
 }
 
+TEST(Branch, SharedConfig) {
+  BranchConfig config("test", DetType::kParticle);
+  auto* particles = new Particles(1);
+
+  Branch branch(config, particles);
+  Branch copy(branch);
+  EXPECT_EQ(&copy.GetConfig(), &branch.GetConfig());
+  EXPECT_EQ(copy.GetConfigHash(), branch.GetConfigHash());
+
+  auto* other_particles = new Particles(1);
+  Branch other(branch, other_particles);
+  EXPECT_EQ(&other.GetConfig(), &branch.GetConfig());
+  EXPECT_EQ(other.GetDataRaw<Particles*>(), other_particles);
+
+  const auto hash = branch.GetConfigHash();
+  copy.SetMutable();
+  copy.NewVariable("new_field", "", Types::kFloat);
+  EXPECT_NE(&copy.GetConfig(), &branch.GetConfig());
+  EXPECT_TRUE(copy.GetConfig().HasField("new_field"));
+  EXPECT_FALSE(branch.GetConfig().HasField("new_field"));
+  EXPECT_EQ(branch.GetConfigHash(), hash);
+  EXPECT_NE(copy.GetConfigHash(), hash);
+
+  delete particles;
+  delete other_particles;
+}
+
 }// namespace
 #endif//ANALYSISTREE_INFRA_BRANCH_TEST_CPP_
@@ -71,14 +71,20 @@ double BranchChannel::Value(const Field& v) const {
   //  assert(v.GetBranchId() == branch_->GetId()); // TODO
   assert(v.IsInitialized());
 
-  if (v.GetName() == "ones") return 1;
-
+  if (v.GetFieldId() < 0 && branch_->GetKinematics() != nullptr) {
+    double value;
+    branch_->GetFieldValues(v, i_channel_, 1, &value);
+    return value;
+  }
   using AnalysisTree::Types;
   switch (v.GetFieldType()) {
     case Types::kFloat: return ANALYSISTREE_UTILS_VISIT(get_field_struct<float>(v.GetFieldId()), data_ptr_);
     case Types::kInteger: return ANALYSISTREE_UTILS_VISIT(get_field_struct<int>(v.GetFieldId()), data_ptr_);
     case Types::kBool: return ANALYSISTREE_UTILS_VISIT(get_field_struct<bool>(v.GetFieldId()), data_ptr_);
-    default: throw std::runtime_error("Field type is not correct!");//NOTE commented because of Ones field NOTE now commented again
+    default: {// "ones" field has no type, name is compared only here
+      if (v.GetName() == "ones") return 1;
+      throw std::runtime_error("Field type is not correct!");
+    }
   }
 }
 
@@ -6,13 +6,34 @@
 #include "Matching.hpp"
 #include "VariantMagic.hpp"
 
+#include <TBranch.h>
 #include <TChain.h>
 #include <TFileCollection.h>
+#include <TTreeCache.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
+#include <sstream>
 
 namespace AnalysisTree {
 
+namespace {
+void WriteFriendRegistry(const std::string& registry, const std::vector<std::pair<std::string, std::string>>& friends) {
+  if (friends.empty()) {
+    std::remove(registry.c_str());
+    return;
+  }
+  std::ofstream out(registry);
+  for (const auto& f : friends) {
+    out << f.first << " " << f.second << "\n";
+  }
+  if (!out) {
+    throw std::runtime_error("AnalysisTree::Chain - cannot write " + registry);
+  }
+}
+}// namespace
+
 TChain* Chain::MakeChain(const std::string& filelist, const std::string& treename) {
   auto chain = new TChain(treename.c_str());
   TFileCollection fc("fc", "", filelist.c_str());
@@ -31,6 +52,56 @@ std::string Chain::LookupAlias(const std::vector<std::string>& names, const std:
   return LookupAlias(names, name, copy + 1);
 }
 
+void Chain::AddRegisteredFriends() {
+  first_registered_friend_ = filelists_.size();
+  if (filelists_.empty()) return;
+  for (const auto& registered : GetRegisteredFriends(filelists_.at(0))) {
+    if (std::find(filelists_.begin(), filelists_.end(), registered.first) != filelists_.end()) {
+      continue;// already added explicitly
+    }
+    std::cout << "Chain::AddRegisteredFriends - " << registered.first << " " << registered.second << std::endl;
+    filelists_.emplace_back(registered.first);
+    treenames_.emplace_back(registered.second);
+  }
+}
+
+std::vector<std::pair<std::string, std::string>> Chain::GetRegisteredFriends(const std::string& filelist) {
+  std::vector<std::pair<std::string, std::string>> result{};
+  std::ifstream in(GetFriendRegistryName(filelist));
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream stream(line);
+    std::string friend_filelist, treename;
+    if (stream >> friend_filelist >> treename) {
+      result.emplace_back(friend_filelist, treename);
+    }
+  }
+  return result;
+}
+
+void Chain::RegisterFriend(const std::string& filelist, const std::string& friend_filelist, const std::string& treename) {
+  auto friends = GetRegisteredFriends(filelist);
+  auto it = std::find_if(friends.begin(), friends.end(), [&friend_filelist](const std::pair<std::string, std::string>& f) {
+    return f.first == friend_filelist;
+  });
+  if (it != friends.end()) {
+    it->second = treename;
+  } else {
+    friends.emplace_back(friend_filelist, treename);
+  }
+  WriteFriendRegistry(GetFriendRegistryName(filelist), friends);
+}
+
+void Chain::UnregisterFriend(const std::string& filelist, const std::string& friend_filelist) {
+  auto friends = GetRegisteredFriends(filelist);
+  auto it = std::remove_if(friends.begin(), friends.end(), [&friend_filelist](const std::pair<std::string, std::string>& f) {
+    return f.first == friend_filelist;
+  });
+  if (it == friends.end()) return;
+  friends.erase(it, friends.end());
+  WriteFriendRegistry(GetFriendRegistryName(filelist), friends);
+}
+
 void Chain::InitChain() {
   /* TODO remove assert, throw exceptions */
   assert(!filelists_.empty() && !treenames_.empty() && filelists_.size() == treenames_.size());
@@ -45,11 +116,22 @@ void Chain::InitChain() {
     aliases.emplace_back(LookupAlias(aliases, tree_name));
   }
 
-  for (size_t i = 1; i < filelists_.size(); i++) {
+  for (size_t i = 1; i < filelists_.size();) {
+    auto* friend_chain = MakeChain(filelists_.at(i), treenames_.at(i));
+    if (i >= first_registered_friend_ && friend_chain->GetEntries() != this->GetEntries()) {
+      std::cout << "Warning: AnalysisTree::Chain::InitChain - registered friend " << filelists_.at(i) << " has " << friend_chain->GetEntries()
+                << " entries instead of " << this->GetEntries() << " and is skipped, see " << GetFriendRegistryName(filelists_.at(0)) << std::endl;
+      delete friend_chain;
+      filelists_.erase(filelists_.begin() + i);
+      treenames_.erase(treenames_.begin() + i);
+      aliases.erase(aliases.begin() + i);
+      continue;
+    }
     if (aliases.at(i) != treenames_.at(i)) {
       std::cout << "Tree '" << treenames_.at(i) << "' will be friended under the alias '" << aliases.at(i) << "'" << std::endl;
     }
-    this->AddFriend(MakeChain(filelists_.at(i), treenames_.at(i)), aliases.at(i).c_str());
+    this->AddFriend(friend_chain, aliases.at(i).c_str());
+    i++;
   }
 
   std::cout << "Ntrees = " << this->GetNtrees() << "\n";
@@ -57,12 +139,26 @@ void Chain::InitChain() {
 }
 
 void Chain::InitPointersToBranches(std::set<std::string> names) {
-  if (names.empty()) {// all branches by default, if not implicitly specified
+  const bool is_all = names.empty();
+  if (is_all) {// all branches by default, if not implicitly specified
     for (const auto& branch : configuration_->GetBranchConfigs()) {
       names.insert(branch.second.GetName());
     }
   }
 
+  std::set<std::string> match_names{};
+  for (const auto& match : configuration_->GetMatches()) {
+    const auto& br = match.first;
+    if (is_all || names.count(match.second) || (names.count(br[0]) && names.count(br[1]))) {
+      match_names.insert(match.second);
+    }
+    names.erase(match.second);
+  }
+
+  if (!is_all) {
+    this->SetBranchStatus("*", false);
+  }
+
   for (const auto& branch : names) {// Init all pointers to branches
     BranchPointer branch_ptr;
     const auto& branch_config = configuration_->GetBranchConfig(branch);
@@ -94,22 +190,19 @@ void Chain::InitPointersToBranches(std::set<std::string> names) {
       }
     }
     branches_.emplace(branch, branch_ptr);
+    branch_objects_.emplace(branch, AnalysisTree::Branch(branch_config, branch_ptr));
+    if (branch_config.GetType() == DetType::kTrack || branch_config.GetType() == DetType::kParticle) {
+      auto columns = kinematics_.emplace(branch, KinematicsColumns(branch_config.GetType())).first;
+      branch_objects_.at(branch).SetKinematics(&columns->second);
+    }
   }
 
-  for (const auto& match : configuration_->GetMatches()) {// Init all pointers to matching //TODO exclude unused
-    std::cout << "Adding branch pointer: " << match.second << std::endl;
-    matches_.emplace(match.second, new Matching);
+  for (const auto& match : match_names) {// Init pointers to used matchings only
+    ActivateMatching(match);
   }
 
-  for (auto& match : matches_) {
-    if (CheckBranchExistence(match.first) == 1)
-      this->SetBranchAddress(match.first.c_str(), &(match.second));
-    else if (CheckBranchExistence(match.first) == 2)
-      this->SetBranchAddress((match.first + ".").c_str(), &(match.second));
-    else
-      throw std::runtime_error("AnalysisTree::InitPointersToBranches - Matching " + match.first + " does not exist");
-  }
   for (auto& branch : branches_) {
+    SetBranchStatusOf(branch.first, true);
     if (CheckBranchExistence(branch.first) == 1)
       ANALYSISTREE_UTILS_VISIT(set_branch_address_struct(this, branch.first), branch.second);
     else if (CheckBranchExistence(branch.first) == 2)
@@ -117,6 +210,210 @@ void Chain::InitPointersToBranches(std::set<std::string> names) {
     else
       throw std::runtime_error("AnalysisTree::InitPointersToBranches - Branch " + branch.first + " does not exist");
   }
+
+  if (!is_all) {
+    std::cout << "Chain::InitPointersToBranches - " << GetSkippedBytesPerEvent() << " bytes per event in disabled branches are not read\n";
+  }
+}
+
+Matching* Chain::ActivateMatching(const std::string& name) {
+  auto it = matches_.find(name);
+  if (it != matches_.end()) {
+    return it->second;
+  }
+  std::cout << "Adding branch pointer: " << name << std::endl;
+  it = matches_.emplace(name, new Matching).first;
+  SetBranchStatusOf(name, true);
+  if (CheckBranchExistence(name) == 1)
+    this->SetBranchAddress(name.c_str(), &(it->second));
+  else if (CheckBranchExistence(name) == 2)
+    this->SetBranchAddress((name + ".").c_str(), &(it->second));
+  else
+    throw std::runtime_error("AnalysisTree::ActivateMatching - Matching " + name + " does not exist");
+  if (cache_size_ > 0) {// requested after InitCache()
+    AddToCache(name);
+  }
+  return it->second;
+}
+
+void Chain::SetBranchStatusOf(const std::string& name, bool status) {
+  if (CheckBranchExistence(name) == 2) {
+    this->SetBranchStatus((name + ".*").c_str(), status);
+  } else {
+    this->SetBranchStatus(name.c_str(), status);// sub-branches are set as well
+  }
+}
+
+void Chain::DisableNotLoadedBranches() {
+  this->SetBranchStatus("*", false);
+  for (const auto& branch : branches_) {
+    SetBranchStatusOf(branch.first, true);
+  }
+  for (const auto& match : matches_) {
+    SetBranchStatusOf(match.first, true);
+  }
+}
+
+void Chain::InitCache(long long size) {
+  cache_size_ = size;
+  if (this->LoadTree(0) < 0) {// no entries, nothing to cache
+    return;
+  }
+  for (auto* chain : GetTChains()) {
+    chain->SetCacheSize(size);
+  }
+  if (size <= 0) {
+    std::cout << "Chain::InitCache - TTreeCache is disabled\n";
+    return;
+  }
+  for (const auto& branch : branches_) {
+    AddToCache(branch.first);
+  }
+  for (const auto& match : matches_) {
+    AddToCache(match.first);
+  }
+  for (auto* chain : GetTChains()) {// list of branches is complete, no learning phase
+    chain->StopCacheLearningPhase();
+  }
+  cache_chains_ = GetTChains();
+  file_stats_.assign(cache_chains_.size(), FileStats());
+  closed_files_stats_ = CacheStats();
+  UpdateFileStats();
+  std::cout << "Chain::InitCache - " << size << " bytes, " << branches_.size() << " branches and " << matches_.size() << " matchings\n";
+}
+
+void Chain::AddToCache(const std::string& name) {
+  for (auto* chain : GetTChains()) {
+    auto* lob = chain->GetListOfBranches();
+    for (const auto& full_name : {name + ".", name}) {
+      if (lob->FindObject(full_name.c_str()) != nullptr) {
+        chain->AddBranchToCache(full_name.c_str(), true);
+        return;
+      }
+    }
+  }
+  throw std::runtime_error("AnalysisTree::Chain::AddToCache - Branch " + name + " does not exist");
+}
+
+Long64_t Chain::LoadTree(Long64_t entry) {
+  if (file_stats_.empty()) {
+    return TChain::LoadTree(entry);
+  }
+  UpdateFileStats();// files may be closed by TChain::LoadTree(), so their counters are taken before
+  const auto result = TChain::LoadTree(entry);
+  UpdateFileStats();
+  return result;
+}
+
+void Chain::UpdateFileStats() {
+  for (size_t i = 0; i < cache_chains_.size(); ++i) {
+    auto* chain = cache_chains_[i];
+    auto* file = chain->GetCurrentFile();
+    auto& stats = file_stats_[i];
+    if (file != stats.file || chain->GetTreeNumber() != stats.tree_number) {// previous file is closed
+      const auto bytes_read = stats.bytes_read - stats.bytes_read_start;
+      closed_files_stats_.read_calls += stats.read_calls - stats.read_calls_start;
+      closed_files_stats_.bytes_read += bytes_read;
+      closed_files_stats_.hit_ratio += stats.hit_ratio * bytes_read;
+      stats = FileStats();
+      stats.file = file;
+      stats.tree_number = chain->GetTreeNumber();
+      if (file != nullptr) {
+        stats.read_calls_start = file->GetReadCalls();
+        stats.bytes_read_start = file->GetBytesRead();
+      }
+    }
+    if (file == nullptr) {
+      continue;
+    }
+    stats.read_calls = file->GetReadCalls();
+    stats.bytes_read = file->GetBytesRead();
+    auto* cache = chain->GetReadCache(file);
+    stats.hit_ratio = cache != nullptr ? cache->GetEfficiency() : 0.;
+  }
+}
+
+Chain::CacheStats Chain::GetCacheStats() {
+  UpdateFileStats();
+  auto stats = closed_files_stats_;
+  for (size_t i = 0; i < cache_chains_.size(); ++i) {
+    const auto& file = file_stats_[i];
+    const auto bytes_read = file.bytes_read - file.bytes_read_start;
+    stats.read_calls += file.read_calls - file.read_calls_start;
+    stats.bytes_read += bytes_read;
+    stats.hit_ratio += file.hit_ratio * bytes_read;
+    auto* cache = cache_chains_[i]->GetReadCache(file.file);
+    if (cache != nullptr) {
+      stats.n_cached_branches += cache->GetCachedBranches()->GetEntries();
+    }
+  }
+  stats.hit_ratio = stats.bytes_read > 0 ? stats.hit_ratio / stats.bytes_read : 0.;
+  return stats;
+}
+
+void Chain::PrintCacheStats() {
+  const auto stats = GetCacheStats();
+  std::cout << "Chain::PrintCacheStats - cache size " << cache_size_ << " bytes, " << stats.n_cached_branches << " cached TBranches\n"
+            << "  hit ratio " << stats.hit_ratio << ", " << stats.read_calls << " read calls, "
+            << stats.bytes_read << " bytes read";
+  if (stats.read_calls > 0) {
+    std::cout << " (" << stats.bytes_read / stats.read_calls << " bytes per call)";
+  }
+  std::cout << std::endl;
+}
+
+double Chain::GetBytesPerEvent(bool is_enabled) {
+  if (this->LoadTree(0) < 0) {
+    return 0.;
+  }
+  double result{0.};
+  for (auto* chain : GetTChains()) {
+    auto* tree = chain->GetTree();
+    if (tree == nullptr || tree->GetEntries() == 0) {
+      continue;
+    }
+    auto* lob = tree->GetListOfBranches();
+    for (int i = 0; i < lob->GetEntries(); ++i) {
+      auto* branch = static_cast<TBranch*>(lob->At(i));
+      if (static_cast<bool>(tree->GetBranchStatus(branch->GetName())) == is_enabled) {
+        result += static_cast<double>(branch->GetTotBytes("*")) / tree->GetEntries();
+      }
+    }
+  }
+  return result;
+}
+
+Int_t Chain::GetEntryOfBranches(Long64_t entry, const std::vector<std::string>& names) {
+  if (this->LoadTree(entry) < 0) {
+    return 0;
+  }
+  Int_t nbytes{0};
+  for (const auto& name : names) {
+    auto it = full_names_.find(name);
+    if (it == full_names_.end()) {
+      it = full_names_.emplace(name, CheckBranchExistence(name) == 2 ? name + "." : name).first;
+    }
+    auto* branch = this->TChain::GetBranch(it->second.c_str());
+    if (branch == nullptr) {
+      throw std::runtime_error("AnalysisTree::Chain::GetEntryOfBranches - Branch " + name + " does not exist");
+    }
+    nbytes += branch->GetEntry(branch->GetTree()->GetReadEntry());
+  }
+  return nbytes;
+}
+
+void Chain::CacheKinematics() {
+  for (auto& columns : kinematics_) {
+    ANALYSISTREE_UTILS_VISIT(cache_kinematics_struct(columns.second), branches_.at(columns.first));
+  }
+}
+
+const KinematicsColumns& Chain::GetKinematics(const std::string& name) const {
+  auto it = kinematics_.find(name);
+  if (it == kinematics_.end()) {
+    throw std::runtime_error("AnalysisTree::Chain::GetKinematics - " + name + " is not a loaded track or particle branch");
+  }
+  return it->second;
 }
 
 void Chain::InitConfiguration() {
@@ -169,12 +466,11 @@ T* Chain::GetObjectFromFileList(const std::string& filelist, const std::string&
 }
 
 class Branch Chain::GetBranchObject(const std::string& name) const {
-  auto it = branches_.find(name);
-  if (it == branches_.end()) {
+  auto handle = branch_objects_.find(name);
+  if (handle == branch_objects_.end()) {
     throw std::runtime_error("Branch " + name + " is not found!");
   }
-  auto ptr = branches_.find(name)->second;
-  return {configuration_->GetBranchConfig(name), ptr};
+  return handle->second;// config is shared, not copied
 }
 
 class Branch Chain::GetBranch(const std::string& name) const {
@@ -242,8 +538,8 @@ int Chain::CheckBranchExistence(const std::string& branchname) {
   return 0;
 }
 
-TTree* Chain::CloneChain(int nentries) {
-  TTree* treeOut = this->CloneTree(nentries);
+TTree* Chain::CloneChain(int nentries, const std::string& option) {
+  TTree* treeOut = this->CloneTree(nentries, option.c_str());
 
   auto* lof = treeOut->GetListOfFriends();
   if (lof != nullptr) {
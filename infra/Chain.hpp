@@ -17,6 +17,7 @@
 #include "Branch.hpp"
 #include "Configuration.hpp"
 #include "DataHeader.hpp"
+#include "KinematicsColumns.hpp"
 #include "Utils.hpp"
 
 namespace AnalysisTree {
@@ -24,6 +25,16 @@ namespace AnalysisTree {
 class Chain : public TChain {
 
  public:
+  /**
+   * @brief Read statistics of the input since InitCache(), see GetCacheStats()
+   */
+  struct CacheStats {
+    long long read_calls{0};    ///< number of read calls to the files of the main and friend chains
+    long long bytes_read{0};    ///< bytes read from the files of the main and friend chains
+    double hit_ratio{0.};       ///< fraction of baskets found in TTreeCache (TTreeCache::GetEfficiency()), mean of all files weighted with bytes read
+    int n_cached_branches{0};///< TBranches (with sub-branches) in TTreeCache of the main and friend chains
+  };
+
   Chain() : TChain() {}
 
   Chain(TTree* tree, Configuration* config, DataHeader* data_header) : TChain(tree->GetName()),
@@ -39,9 +50,17 @@ class Chain : public TChain {
     this->Add(filename.c_str());
   }
 
-  Chain(std::vector<std::string> filelists, std::vector<std::string> treenames) : TChain(treenames.at(0).c_str()),
-                                                                                  filelists_(std::move(filelists)),
-                                                                                  treenames_(std::move(treenames)) {
+  /**
+   * @param is_read_registered_friends if true, friends registered for the first filelist with RegisterFriend() are added
+   */
+  Chain(std::vector<std::string> filelists, std::vector<std::string> treenames, bool is_read_registered_friends = false) : TChain(treenames.at(0).c_str()),
+                                                                                                                          filelists_(std::move(filelists)),
+                                                                                                                          treenames_(std::move(treenames)) {
+    if (is_read_registered_friends) {
+      AddRegisteredFriends();
+    } else {
+      first_registered_friend_ = filelists_.size();
+    }
     InitChain();
     InitConfiguration();
     InitDataHeader();
@@ -51,6 +70,8 @@ class Chain : public TChain {
   ANALYSISTREE_ATTR_NODISCARD DataHeader* GetDataHeader() const { return data_header_; }
   ANALYSISTREE_ATTR_NODISCARD const std::map<std::string, BranchPointer>& GetBranchPointers() const { return branches_; }
   ANALYSISTREE_ATTR_NODISCARD const std::map<std::string, Matching*>& GetMatchPointers() const { return matches_; }
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<std::string>& GetFileLists() const { return filelists_; }
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<std::string>& GetTreeNames() const { return treenames_; }
 
   void SetDataHeader(DataHeader* dh) { data_header_ = dh; }
 
@@ -66,13 +87,64 @@ class Chain : public TChain {
   }
 
   /**
- * @brief Loads selected list of branches from TTree
- * @param t
- * @param config
- * @param names List of selected branches. If empty, loads all branches found in Configuration
+ * @brief Loads selected list of branches from TTree. Other branches are disabled with SetBranchStatus() and not read.
+ * Matchings are loaded if both matched branches are selected, if the name of the matching is in the list,
+ * or later on request with GetMatching()
+ * @param names List of selected branches and matchings. If empty, loads all branches and matchings found in Configuration
  */
   void InitPointersToBranches(std::set<std::string> names);
 
+  /**
+ * @brief Sets up TTreeCache of the main and friend chains for the loaded branches and matchings only, without
+ * learning phase. Matchings loaded later with GetMatching() are added to the cache as well.
+ * Should be called after InitPointersToBranches()
+ * @param size size of the cache of every chain in bytes, 0 disables the cache
+ */
+  void InitCache(long long size);
+
+  /**
+ * @return read statistics of the files of this chain since InitCache(), files already closed included
+ */
+  ANALYSISTREE_ATTR_NODISCARD CacheStats GetCacheStats();
+
+  /**
+ * @brief Loads the tree of entry as TChain::LoadTree(), statistics of the files closed on the way are kept for GetCacheStats()
+ */
+  Long64_t LoadTree(Long64_t entry) override;
+  void PrintCacheStats();
+
+  /**
+ * @return size of disabled branches per event (uncompressed, in bytes), estimated with the first tree
+ */
+  double GetSkippedBytesPerEvent() { return GetBytesPerEvent(false); }
+
+  /**
+ * @return size of enabled branches per event (uncompressed, in bytes), estimated with the first tree
+ */
+  double GetReadBytesPerEvent() { return GetBytesPerEvent(true); }
+
+  /**
+ * @brief Reads only listed branches of the entry, other branches keep their previous content.
+ * Allows to check event cuts before all the other branches are read with GetEntry()
+ * @param entry entry number
+ * @param names names of branches, should be loaded with InitPointersToBranches()
+ * @return number of bytes read
+ */
+  Int_t GetEntryOfBranches(Long64_t entry, const std::vector<std::string>& names);
+
+  /**
+ * @brief Computes kinematics of all tracks and particles of the loaded branches in one pass per branch
+ * and keeps it in KinematicsColumns of the branch. Should be called after the entry is read.
+ * Branch objects of the chain read pT, p, phi, eta, energy and rapidity from the columns,
+ * channels changed after this call are computed from the object again, see KinematicsColumns::Read()
+ */
+  void CacheKinematics();
+
+  /**
+ * @brief Returns kinematics of the loaded track or particle branch, computed by the last CacheKinematics() call
+ */
+  ANALYSISTREE_ATTR_NODISCARD const KinematicsColumns& GetKinematics(const std::string& name) const;
+
   Long64_t Draw(const char* varexp, const char* selection = nullptr, Option_t* option = "", Long64_t nentries = kMaxEntries, Long64_t firstentry = 0) override;
   Long64_t Scan(const char* varexp, const char* selection = nullptr, Option_t* option = "", Long64_t nentries = kMaxEntries, Long64_t firstentry = 0) override;
 
@@ -83,31 +155,68 @@ class Chain : public TChain {
 
   [[deprecated("Will be removed soon to avoid confusion with TChain::GetBranch. Use GetBranchObject")]] class Branch GetBranch(const std::string& name) const;
 
+  /**
+ * @brief Returns handle of the loaded branch. Handles of the same branch share one BranchConfig, so the call is cheap
+ */
   class Branch GetBranchObject(const std::string& name) const;
 
+  /**
+ * @brief Returns matching between branches br1 and br2, it is enabled for reading if not loaded yet
+ */
+  Matching* GetMatching(const std::string& br1, const std::string& br2) {
+    return ActivateMatching(configuration_->GetMatchName(br1, br2));
+  }
+
+  /**
+ * @brief Returns matching between branches br1 and br2, which should be already loaded
+ */
   Matching* GetMatching(const std::string& br1, const std::string& br2) const {
     auto match = matches_.find(configuration_->GetMatchName(br1, br2));
     if (match == matches_.end()) {
-      throw std::runtime_error("No matching found");
+      throw std::runtime_error("AnalysisTree::Chain::GetMatching - matching of " + br1 + " and " + br2 + " is not loaded");
     }
     return match->second;
   }
 
   /**
  * @brief Clones tree without friends
+ * @param nentries number of entries to copy, -1 for all
+ * @param option see TTree::CloneTree(), "fast" copies compressed baskets without unpacking them
+ */
+  TTree* CloneChain(int nentries = 0, const std::string& option = "");
+
+  /**
+ * @brief Disables reading of all branches except the loaded ones, see InitPointersToBranches() and GetMatching()
  */
-  TTree* CloneChain(int nentries = 0);
+  void DisableNotLoadedBranches();
 
   /**
  * @brief Clones Configuration of input Chain without friends
  */
   Configuration* CloneConfiguration() const;
 
+  /**
+ * @brief Registers friend_filelist, so that its tree is friended to Chain created from filelist with is_read_registered_friends.
+ * Number of entries of the friend is checked then, a friend with another number of entries is skipped with a warning.
+ * Friends are stored in the text file GetFriendRegistryName(filelist), one "friend_filelist treename" pair per line.
+ * See also eBranchWriteMode::kFriendTree and TaskManager::SetIsReadRegisteredFriends()
+ */
+  static void RegisterFriend(const std::string& filelist, const std::string& friend_filelist, const std::string& treename);
+  static void UnregisterFriend(const std::string& filelist, const std::string& friend_filelist);
+  static std::vector<std::pair<std::string, std::string>> GetRegisteredFriends(const std::string& filelist);
+  static std::string GetFriendRegistryName(const std::string& filelist) { return filelist + ".friends"; }
+
  protected:
+  void AddRegisteredFriends();
   void InitChain();
   void InitConfiguration();
   void InitDataHeader();
 
+  Matching* ActivateMatching(const std::string& name);
+  void AddToCache(const std::string& name);
+  void SetBranchStatusOf(const std::string& name, bool status);
+  double GetBytesPerEvent(bool is_enabled);
+
   static TChain* MakeChain(const std::string& filelist, const std::string& treename);
 
   /**
@@ -130,12 +239,35 @@ class Chain : public TChain {
 
   std::vector<std::string> filelists_{};
   std::vector<std::string> treenames_{};
+  size_t first_registered_friend_{0};///< index of the first friend found with GetRegisteredFriends() in filelists_
 
   Configuration* configuration_{nullptr};
   DataHeader* data_header_{nullptr};
 
   std::map<std::string, BranchPointer> branches_{};
   std::map<std::string, Matching*> matches_{};
+  std::map<std::string, std::string> full_names_{};//! names of TBranches, with trailing dot if needed
+  std::map<std::string, class Branch> branch_objects_{};//! handles returned by GetBranchObject(), filled in InitPointersToBranches()
+  std::map<std::string, KinematicsColumns> kinematics_{};//! see CacheKinematics(), filled in InitPointersToBranches()
+
+  /**
+   * @brief Last seen read statistics of the current file of one of the chains
+   */
+  struct FileStats {
+    TFile* file{nullptr};
+    int tree_number{-1};
+    long long read_calls_start{0};///< counters of the file when it was seen first
+    long long bytes_read_start{0};
+    long long read_calls{0};
+    long long bytes_read{0};
+    double hit_ratio{0.};
+  };
+  void UpdateFileStats();
+
+  long long cache_size_{0};             //!
+  std::vector<TChain*> cache_chains_{}; //! main and friend chains, see InitCache()
+  std::vector<FileStats> file_stats_{}; //! current files of cache_chains_
+  CacheStats closed_files_stats_{};     //! files already closed, hit_ratio is weighted with bytes read
 
   ClassDefOverride(AnalysisTree::Chain, 1)
 };
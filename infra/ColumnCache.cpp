@@ -0,0 +1,178 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include "ColumnCache.hpp"
+
+#include <TChain.h>
+#include <TChainElement.h>
+#include <TFile.h>
+#include <TFriendElement.h>
+#include <TKey.h>
+#include <TNamed.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+namespace AnalysisTree {
+
+ColumnCache::~ColumnCache() {
+  if (file_ != nullptr) {// not written, trees are deleted together with the file
+    file_->Close();
+    delete file_;
+  }
+  for (auto& column : columns_) {
+    delete column.values;
+  }
+}
+
+size_t ColumnCache::AddColumn(const Variable& var) {
+  if (file_ != nullptr) {
+    throw std::runtime_error("ColumnCache::AddColumn - cache is already initialized");
+  }
+  if (var.GetNumberOfBranches() != 1) {
+    throw std::runtime_error("ColumnCache::AddColumn - Variable " + var.GetName() + " should depend on one branch");
+  }
+  if (!var.IsDefinitionComplete()) {
+    throw std::runtime_error("ColumnCache::AddColumn - lambda of Variable " + var.GetName() + " cannot be identified, use Variable::FromExpression() or Variable::SetVersion()");
+  }
+  const auto definition = var.GetDefinition();
+  auto it = std::find_if(columns_.begin(), columns_.end(), [&definition](const CachedColumn& column) {
+    return column.definition == definition;
+  });
+  if (it != columns_.end()) {
+    return std::distance(columns_.begin(), it);
+  }
+  CachedColumn column;
+  column.definition = definition;
+  column.values = new std::vector<double>;
+  columns_.emplace_back(std::move(column));
+  return columns_.size() - 1;
+}
+
+void ColumnCache::Init(TChain& chain) {
+  TDirectory::TContext context;// current directory is restored in the end
+  if (chain.GetListOfFiles()->GetEntries() == 0) {
+    throw std::runtime_error("ColumnCache::Init - input should be read from files");
+  }
+  identity_ = GetInputIdentity(chain);
+  n_entries_ = chain.GetEntries();
+  n_filled_ = 0;
+  is_complete_ = true;
+
+  file_ = TFile::Open(filename_.c_str(), "update");
+  if (file_ == nullptr || file_->IsZombie()) {
+    throw std::runtime_error("ColumnCache::Init - cannot open " + filename_);
+  }
+  for (auto& column : columns_) {
+    column.name = "column_" + std::to_string(std::hash<std::string>()(identity_ + "|" + column.definition));
+    auto* key = dynamic_cast<TNamed*>(file_->Get((column.name + "_key").c_str()));
+    auto* tree = dynamic_cast<TTree*>(file_->Get(column.name.c_str()));
+    column.is_cached = key != nullptr && tree != nullptr && column.definition == key->GetName() && identity_ == key->GetTitle() && tree->GetEntries() == n_entries_;
+    delete key;
+    if (column.is_cached) {
+      column.tree = tree;
+      column.tree->SetBranchAddress("values", &column.values);
+    } else {
+      delete tree;
+      column.tree = new TTree(column.name.c_str(), column.definition.c_str());
+      column.tree->SetDirectory(file_);
+      column.tree->Branch("values", &column.values);
+    }
+  }
+  std::cout << "ColumnCache::Init - " << GetNumberOfCached() << " of " << columns_.size() << " columns are read from " << filename_ << "\n";
+}
+
+void ColumnCache::SetEntry(long long entry) {
+  if (entry != n_filled_) {
+    is_complete_ = false;
+  }
+  for (auto& column : columns_) {
+    if (column.is_cached) {
+      column.tree->GetEntry(entry);
+    } else {
+      column.values->clear();
+    }
+  }
+}
+
+void ColumnCache::Fill() {
+  if (!is_complete_) return;
+  for (auto& column : columns_) {
+    if (!column.is_cached) {
+      column.tree->Fill();
+    }
+  }
+  ++n_filled_;
+}
+
+void ColumnCache::Write() {
+  if (file_ == nullptr) return;
+  TDirectory::TContext context(file_);
+
+  const bool is_write = is_complete_ && n_filled_ == n_entries_;
+  for (auto& column : columns_) {
+    if (column.is_cached) continue;
+    if (is_write) {
+      column.tree->Write("", TObject::kOverwrite);
+      TNamed(column.definition, identity_).Write((column.name + "_key").c_str(), TObject::kOverwrite);
+    } else {
+      std::cout << "ColumnCache::Write - not all entries were processed, column " << column.definition << " is not stored\n";
+    }
+  }
+
+  std::vector<std::string> stale{};// columns of other inputs
+  for (auto* obj : *file_->GetListOfKeys()) {
+    const std::string name = obj->GetName();
+    if (name.rfind("column_", 0) != 0 || name.size() < 4 || name.substr(name.size() - 4) != "_key") continue;
+    std::unique_ptr<TNamed> key{dynamic_cast<TNamed*>(static_cast<TKey*>(obj)->ReadObj())};
+    if (key == nullptr || identity_ != key->GetTitle()) {
+      stale.emplace_back(name.substr(0, name.size() - 4));
+    }
+  }
+  for (const auto& name : stale) {
+    file_->Delete((name + ";*").c_str());
+    file_->Delete((name + "_key;*").c_str());
+  }
+
+  file_->Close();
+  delete file_;
+  file_ = nullptr;
+  for (auto& column : columns_) {
+    column.tree = nullptr;
+  }
+}
+
+size_t ColumnCache::GetNumberOfCached() const {
+  return std::count_if(columns_.begin(), columns_.end(), [](const CachedColumn& column) { return column.is_cached; });
+}
+
+std::string ColumnCache::GetInputIdentity(TChain& chain) {
+  TDirectory::TContext context;
+  std::vector<TChain*> chains{&chain};
+  if (auto* friends = chain.GetListOfFriends()) {
+    for (auto* obj : *friends) {
+      if (auto* friend_chain = dynamic_cast<TChain*>(static_cast<TFriendElement*>(obj)->GetTree())) {
+        chains.emplace_back(friend_chain);
+      }
+    }
+  }
+  std::string result = std::to_string(chain.GetEntries());
+  for (auto* ch : chains) {
+    for (auto* element : *ch->GetListOfFiles()) {
+      const auto* filename = static_cast<TChainElement*>(element)->GetTitle();
+      std::unique_ptr<TFile> file{TFile::Open(filename, "read")};
+      if (file == nullptr || file->IsZombie()) {
+        throw std::runtime_error("ColumnCache::GetInputIdentity - cannot open " + std::string(filename));
+      }
+      result += " ";
+      result += file->GetUUID().AsString();
+    }
+  }
+  return result;
+}
+
+}// namespace AnalysisTree
@@ -0,0 +1,94 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_COLUMNCACHE_HPP_
+#define ANALYSISTREE_INFRA_COLUMNCACHE_HPP_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Variable.hpp"
+
+class TChain;
+class TFile;
+class TTree;
+
+namespace AnalysisTree {
+
+/**
+ * @brief ColumnCache keeps values of Variables of one branch, for all channels of every entry, in a sidecar ROOT file,
+ * so that they are read instead of being computed again in the next runs over the same input.
+ * Every column is a TTree "column_<hash>" with one std::vector<double> per entry. The key of a column is the input
+ * identity (UUIDs and number of entries of all input files, see GetInputIdentity()) and Variable::GetDefinition().
+ * Columns with another key, or with wrong number of entries, are stale: they are computed again and replaced in Write().
+ * New columns are stored only if all entries of the input were processed in order.
+ */
+class ColumnCache {
+
+ public:
+  explicit ColumnCache(std::string filename) : filename_(std::move(filename)) {}
+  ColumnCache(const ColumnCache&) = delete;
+  ColumnCache& operator=(const ColumnCache&) = delete;
+  virtual ~ColumnCache();
+
+  /**
+   * @brief Registers column of var, should be called before Init(). Variable should depend on one branch only,
+   * and its definition should be complete (see Variable::IsDefinitionComplete()), so that a changed lambda is not
+   * served from a stale column
+   * @return index of the column, columns with the same definition are shared
+   */
+  size_t AddColumn(const Variable& var);
+
+  /**
+   * @brief Opens (or creates) the cache file and finds valid columns for the input
+   */
+  void Init(TChain& chain);
+
+  /**
+   * @brief Reads cached columns of the entry, columns to compute are cleared
+   */
+  void SetEntry(long long entry);
+
+  /**
+   * @brief Stores computed columns of the current entry
+   */
+  void Fill();
+
+  /**
+   * @brief Writes computed columns to the cache file, if they are complete, and removes stale ones
+   */
+  void Write();
+
+  ANALYSISTREE_ATTR_NODISCARD bool IsCached(size_t i_column) const { return columns_.at(i_column).is_cached; }
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<double>& GetColumn(size_t i_column) const { return *columns_.at(i_column).values; }
+  /**
+   * @brief Column of the current entry to be filled, if it is not cached
+   */
+  ANALYSISTREE_ATTR_NODISCARD std::vector<double>& Column(size_t i_column) { return *columns_.at(i_column).values; }
+  ANALYSISTREE_ATTR_NODISCARD size_t GetNumberOfColumns() const { return columns_.size(); }
+  ANALYSISTREE_ATTR_NODISCARD size_t GetNumberOfCached() const;
+
+  static std::string GetInputIdentity(TChain& chain);
+
+ private:
+  struct CachedColumn {
+    std::string definition{};
+    std::string name{};
+    TTree* tree{nullptr};
+    std::vector<double>* values{nullptr};
+    bool is_cached{false};
+  };
+
+  std::string filename_;
+  std::string identity_{};
+  TFile* file_{nullptr};
+  std::vector<CachedColumn> columns_{};
+  long long n_entries_{0};
+  long long n_filled_{0};
+  bool is_complete_{true};///< computed columns are filled for entries 0, 1, 2, ...
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_INFRA_COLUMNCACHE_HPP_
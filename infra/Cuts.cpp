@@ -2,6 +2,7 @@
    SPDX-License-Identifier: GPL-3.0-only
    Authors: Viktor Klochkov, Ilya Selyuzhenkov */
 #include "Cuts.hpp"
+#include "Branch.hpp"
 #include "Configuration.hpp"
 
 #include <iostream>
@@ -77,6 +78,67 @@ bool Cuts::Apply(const BranchChannel& ob) const {
   return true;
 }
 
+bool Cuts::Apply(const BranchChannel& ob, std::vector<double>& values) const {
+  if (!is_init_) {
+    throw std::runtime_error("Cuts::Apply - cut is not initialized!!");
+  }
+  for (const auto& cut : cuts_) {
+    if (!cut.Apply(ob, values))
+      return false;
+  }
+  return true;
+}
+
+void Cuts::Bind(const std::vector<size_t>& branch_ids) {
+  if (!is_init_) {
+    throw std::runtime_error("Cuts::Bind - cut is not initialized!!");
+  }
+  for (auto& cut : cuts_) {
+    cut.Bind(branch_ids);
+  }
+}
+
+bool Cuts::ApplyBound(const std::vector<const BranchChannel*>& bch, std::vector<double>& values) const {
+  for (const auto& cut : cuts_) {
+    if (!cut.ApplyBound(bch, values))
+      return false;
+  }
+  return true;
+}
+
+void Cuts::ApplyBatch(const Branch& branch, std::vector<char>& mask, std::vector<double>& column, std::vector<double>& values) const {
+  if (!is_init_) {
+    throw std::runtime_error("Cuts::ApplyBatch - cut is not initialized!!");
+  }
+  mask.assign(branch.size(), 1);
+  for (const auto& cut : cuts_) {
+    cut.ApplyBatch(branch, mask, column, values);
+  }
+}
+
+void Cuts::ApplyBatch(const Branch& branch, std::vector<char>& mask) const {
+  std::vector<double> column;
+  std::vector<double> values;
+  ApplyBatch(branch, mask, column, values);
+}
+
+std::vector<char> Cuts::ApplyBatch(const Branch& branch) const {
+  std::vector<char> mask;
+  ApplyBatch(branch, mask);
+  return mask;
+}
+
+bool Cuts::IsBatchable(const std::string& branch) const {
+  for (const auto& cut : cuts_) {
+    for (const auto& var : cut.GetVariables()) {
+      if (var.GetNumberOfBranches() != 1 || var.GetBranchName() != branch) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 void Cuts::AddCut(const SimpleCut& cut) {
   cuts_.emplace_back(cut);
   branch_names_.insert(cut.GetBranches().begin(), cut.GetBranches().end());
@@ -71,10 +71,34 @@ class Cuts {
   }
 
   bool Apply(const BranchChannel& ob) const;
+  /**
+   * @param values scratch buffer of the caller, see SimpleCut::Apply()
+   */
+  bool Apply(const BranchChannel& ob, std::vector<double>& values) const;
 
   bool Apply(std::vector<const BranchChannel*>& bch, std::vector<size_t>& id) const;
   [[deprecated]] bool Apply(const BranchChannel& a, size_t a_id, const BranchChannel& b, size_t b_id) const;
 
+  /**
+   * @brief Binds Variables of all SimpleCuts to the branch positions, see Variable::Bind()
+   * @param branch_ids ids of the branches in the same order as BranchChannels passed to ApplyBound()
+   */
+  void Bind(const std::vector<size_t>& branch_ids);
+  bool ApplyBound(const std::vector<const BranchChannel*>& bch, std::vector<double>& values) const;
+
+  /**
+   * @brief Evaluates all SimpleCuts for all channels of the branch at once, see SimpleCut::ApplyBatch()
+   * @param mask byte mask resized to the number of channels, mask[i] is 1 if channel i passes the cuts and 0 otherwise
+   */
+  void ApplyBatch(const Branch& branch, std::vector<char>& mask, std::vector<double>& column, std::vector<double>& values) const;
+  void ApplyBatch(const Branch& branch, std::vector<char>& mask) const;
+  ANALYSISTREE_ATTR_NODISCARD std::vector<char> ApplyBatch(const Branch& branch) const;
+
+  /**
+   * @return true if all SimpleCuts are defined on the branch only, so that ApplyBatch() can be used
+   */
+  ANALYSISTREE_ATTR_NODISCARD bool IsBatchable(const std::string& branch) const;
+
   void Init(const Configuration& conf);
   void Print() const;
 
@@ -14,6 +14,7 @@
 #include <core/Configuration.hpp>
 #include <core/Track.hpp>
 
+#include <infra/Branch.hpp>
 #include <infra/Cuts.hpp>
 #include <infra/SimpleCut.hpp>
 
@@ -125,6 +126,38 @@ TEST(Cuts, FunctionalCut) {
   ASSERT_TRUE(Nhits_true.Apply({track}));
 }
 
+TEST(Cuts, ApplyBatch) {
+
+  BranchConfig VtxTracksBranch("VtxTracks", DetType::kTrack);
+  VtxTracksBranch.AddField<float>("chi2", "");
+  VtxTracksBranch.AddField<int>("nhits", "");
+  Configuration conf;
+  conf.AddBranchConfig(VtxTracksBranch);
+
+  auto* tracks = new TrackDetector(VtxTracksBranch.GetId());
+  for (int i = 0; i < 20; ++i) {
+    auto& track = tracks->AddChannel(VtxTracksBranch);
+    track.SetMomentum(0.1f * i, 0.f, 1.f);
+    track.SetField(float(i), VtxTracksBranch.GetFieldId("chi2"));
+    track.SetField(i % 4, VtxTracksBranch.GetFieldId("nhits"));
+  }
+  Branch branch(VtxTracksBranch, tracks);
+
+  SimpleCut pt_cut({"VtxTracks.pT"}, [](std::vector<double>& pt) { return pt[0] > 0.45; });
+  Cuts cuts("cuts", {RangeCut("VtxTracks.chi2", 2., 15.), EqualsCut("VtxTracks.nhits", 1), pt_cut});
+  cuts.Init(conf);
+  ASSERT_TRUE(cuts.IsBatchable("VtxTracks"));
+
+  const auto mask = cuts.ApplyBatch(branch);
+  ASSERT_EQ(mask.size(), 20);
+  for (size_t i = 0; i < mask.size(); ++i) {
+    EXPECT_EQ(bool(mask[i]), cuts.Apply(branch[i])) << "channel " << i;
+  }
+  EXPECT_TRUE(mask[5]);
+  EXPECT_FALSE(mask[1]);
+  EXPECT_FALSE(mask[17]);
+}
+
 }// namespace
 
 #endif
\ No newline at end of file
@@ -0,0 +1,132 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include "EntryPrefetcher.hpp"
+
+#include "VariantMagic.hpp"
+
+#include <algorithm>
+
+namespace AnalysisTree {
+
+EntryPrefetcher::EntryPrefetcher(Chain* reader, size_t depth) : reader_(reader) {
+  if (reader_ == nullptr) {
+    throw std::runtime_error("EntryPrefetcher - reader Chain is nullptr");
+  }
+  slots_.resize(std::max<size_t>(depth, 1));
+  for (auto& slot : slots_) {
+    for (const auto& branch : reader_->GetBranchPointers()) {
+      slot.branches.emplace(branch.first, ANALYSISTREE_UTILS_VISIT(new_object_struct(), branch.second));
+    }
+    for (const auto& match : reader_->GetMatchPointers()) {
+      slot.matches.emplace(match.first, new Matching);
+    }
+  }
+}
+
+EntryPrefetcher::~EntryPrefetcher() {
+  Stop();
+  for (auto& slot : slots_) {
+    for (auto& branch : slot.branches) {
+      ANALYSISTREE_UTILS_VISIT(delete_object_struct(), branch.second);
+    }
+    for (auto& match : slot.matches) {
+      delete match.second;
+    }
+  }
+  delete reader_;
+}
+
+void EntryPrefetcher::Start(long long first, long long last) {
+  Stop();
+  i_read_ = 0;
+  i_write_ = 0;
+  n_ready_ = 0;
+  is_stop_ = false;
+  is_done_ = false;
+  error_ = nullptr;
+  thread_ = std::thread(&EntryPrefetcher::Read, this, first, last);
+}
+
+void EntryPrefetcher::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stop_ = true;
+  }
+  cv_free_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void EntryPrefetcher::Read(long long first, long long last) {
+  try {
+    for (long long entry = first; entry < last; ++entry) {
+      {// entry is decoded only into a free slot, so that not more than (depth + 1) entries are kept
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_free_.wait(lock, [this] { return is_stop_ || n_ready_ < slots_.size(); });
+        if (is_stop_) return;
+      }
+      reader_->GetEntry(entry);
+      // slot is not visible to the consumer until n_ready_ is increased
+      auto& slot = slots_.at(i_write_);
+      SwapContent(slot, reader_->GetBranchPointers(), reader_->GetMatchPointers());
+      slot.entry = entry;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        i_write_ = (i_write_ + 1) % slots_.size();
+        ++n_ready_;
+      }
+      cv_ready_.notify_one();
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_done_ = true;
+  }
+  cv_ready_.notify_one();
+}
+
+long long EntryPrefetcher::Next(Chain& target) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_ready_.wait(lock, [this] { return n_ready_ > 0 || is_done_; });
+    if (n_ready_ == 0) {
+      if (error_) std::rethrow_exception(error_);
+      throw std::runtime_error("EntryPrefetcher::Next - no more entries to read");
+    }
+  }
+  auto& slot = slots_.at(i_read_);
+  SwapContent(slot, target.GetBranchPointers(), target.GetMatchPointers());
+  const auto entry = slot.entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    i_read_ = (i_read_ + 1) % slots_.size();
+    --n_ready_;
+  }
+  cv_free_.notify_one();
+  return entry;
+}
+
+void EntryPrefetcher::SwapContent(Slot& slot, const std::map<std::string, BranchPointer>& branches, const std::map<std::string, Matching*>& matches) {
+  for (const auto& branch : branches) {
+    ANALYSISTREE_UTILS_VISIT(swap_content_struct(slot.branches.at(branch.first)), branch.second);
+  }
+  for (const auto& match : matches) {
+    std::swap(*match.second, *slot.matches.at(match.first));
+  }
+}
+
+size_t EntryPrefetcher::GetDepthForMemory(Chain& chain, size_t memory_limit) {
+  const auto entry_size = chain.GetReadBytesPerEvent();
+  if (entry_size <= 0) {
+    return 1;
+  }
+  const auto n_entries = static_cast<size_t>(memory_limit / entry_size);// (depth + 1) entries are kept
+  return n_entries > 1 ? n_entries - 1 : 1;
+}
+
+}// namespace AnalysisTree
@@ -0,0 +1,93 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_ENTRYPREFETCHER_HPP_
+#define ANALYSISTREE_INFRA_ENTRYPREFETCHER_HPP_
+
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Chain.hpp"
+#include "Matching.hpp"
+
+namespace AnalysisTree {
+
+/**
+ * @brief EntryPrefetcher reads entries of the input in a background thread, ahead of the event loop.
+ * It owns a separate Chain (reader) and a ring of slots, each holding a full set of branch and matching objects.
+ * The reader thread decodes entries into free slots; Next() moves the oldest ready entry into the objects
+ * of the target Chain by swapping contents, so pointers held by tasks (e.g. in Branch objects) stay valid.
+ * Memory use is bounded by the number of slots: (depth + 1) decoded entries are kept at most, depth in the slots
+ * (or in the reader being decoded) and one in the target Chain.
+ */
+class EntryPrefetcher {
+
+ public:
+  /**
+   * @param reader Chain used by the background thread, with pointers to the same branches as the target Chain.
+   * EntryPrefetcher takes ownership
+   * @param depth number of entries decoded in advance
+   */
+  EntryPrefetcher(Chain* reader, size_t depth);
+  EntryPrefetcher(const EntryPrefetcher&) = delete;
+  EntryPrefetcher& operator=(const EntryPrefetcher&) = delete;
+  virtual ~EntryPrefetcher();
+
+  /**
+   * @brief Starts reading entries [first, last) in the background thread
+   */
+  void Start(long long first, long long last);
+
+  /**
+   * @brief Blocks until the next entry is decoded and swaps it into branch and matching objects of the target Chain
+   * @return number of the entry
+   */
+  long long Next(Chain& target);
+
+  /**
+   * @brief Stops the background thread, not yet consumed entries are discarded
+   */
+  void Stop();
+
+  ANALYSISTREE_ATTR_NODISCARD size_t GetDepth() const { return slots_.size(); }
+
+  /**
+   * @brief Estimates number of entries which fit in memory_limit bytes, based on the mean uncompressed size of the enabled
+   * branches in the first tree, see Chain::GetReadBytesPerEvent(). Loads the first tree of chain, so the reader Chain
+   * should be passed rather than the one of the event loop
+   */
+  static size_t GetDepthForMemory(Chain& chain, size_t memory_limit);
+
+ private:
+  struct Slot {
+    std::map<std::string, BranchPointer> branches{};
+    std::map<std::string, Matching*> matches{};
+    long long entry{-1};
+  };
+
+  void Read(long long first, long long last);
+  static void SwapContent(Slot& slot, const std::map<std::string, BranchPointer>& branches, const std::map<std::string, Matching*>& matches);
+
+  Chain* reader_{nullptr};///< owns
+  std::vector<Slot> slots_{};
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_ready_;
+  std::condition_variable cv_free_;
+  size_t i_read_{0};
+  size_t i_write_{0};
+  size_t n_ready_{0};
+  bool is_stop_{false};
+  bool is_done_{false};
+  std::exception_ptr error_{nullptr};
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_INFRA_ENTRYPREFETCHER_HPP_
@@ -0,0 +1,150 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include "EventStore.hpp"
+
+#include "VariantMagic.hpp"
+
+#include <stdexcept>
+
+namespace AnalysisTree {
+
+namespace {
+size_t GetContentSize(const Container& container) {
+  return container.GetVector<float>().capacity() * sizeof(float)
+         + container.GetVector<int>().capacity() * sizeof(int)
+         + container.GetVector<bool>().capacity() / 8;
+}
+
+struct get_memory_size_struct : public Utils::Visitor<size_t> {
+  template<class T>
+  size_t operator()(Detector<T>* d) const {
+    size_t result = sizeof(*d) + d->GetChannels()->capacity() * sizeof(T);
+    for (const auto& channel : *d->GetChannels()) {
+      result += GetContentSize(channel);
+    }
+    return result;
+  }
+  size_t operator()(EventHeader* d) const { return sizeof(*d) + GetContentSize(*d); }
+};
+
+struct stream_object_struct : public Utils::Visitor<void> {
+  explicit stream_object_struct(TBuffer& buffer) : buffer_(buffer) {}
+  template<class Entity>
+  void operator()(Entity* d) const { buffer_.StreamObject(d, Entity::Class()); }
+  TBuffer& buffer_;
+};
+}// namespace
+
+EventStore::~EventStore() {
+  Clear();
+}
+
+void EventStore::Clear() {
+  entries_.clear();
+  index_.clear();
+  branch_names_.clear();
+  match_names_.clear();
+  memory_usage_ = 0;
+  n_refused_ = 0;
+  first_refused_ = -1;
+  last_refused_ = -1;
+}
+
+bool EventStore::Add(long long entry, const Chain& chain) {
+  if (Contains(entry)) {
+    return true;
+  }
+  if (n_refused_ > 0) {// the store is full
+    Refuse(entry);
+    return false;
+  }
+  if (entries_.empty()) {// layout is defined by the first entry
+    for (const auto& branch : chain.GetBranchPointers()) {
+      branch_names_.emplace_back(branch.first);
+    }
+    for (const auto& match : chain.GetMatchPointers()) {
+      match_names_.emplace_back(match.first);
+    }
+  }
+  if (chain.GetBranchPointers().size() != branch_names_.size() || chain.GetMatchPointers().size() != match_names_.size()) {
+    throw std::runtime_error("EventStore::Add - branches of the Chain are different from the stored ones");
+  }
+
+  buffer_.SetBufferOffset(0);
+  buffer_.ResetMap();
+  for (const auto& name : branch_names_) {
+    ANALYSISTREE_UTILS_VISIT(stream_object_struct(buffer_), chain.GetPointerToBranch(name));
+  }
+  for (const auto& name : match_names_) {
+    buffer_.StreamObject(chain.GetMatchPointers().at(name), Matching::Class());
+  }
+  const auto length = static_cast<size_t>(buffer_.Length());
+  const auto size = sizeof(std::vector<char>) + length;
+  if (memory_limit_ > 0 && memory_usage_ + size > memory_limit_) {
+    first_refused_ = entry;
+    std::cout << "EventStore::Add - memory limit of " << memory_limit_ / 1024 / 1024 << " MB is reached after "
+              << entries_.size() << " entries, entries starting from " << entry << " are read from the input\n";
+    Refuse(entry);
+    return false;
+  }
+
+  index_.emplace(entry, entries_.size());
+  entries_.emplace_back(buffer_.Buffer(), buffer_.Buffer() + length);
+  memory_usage_ += size;
+  return true;
+}
+
+void EventStore::Refuse(long long entry) {
+  if (entry > last_refused_) {// entries are passed again in every pass
+    ++n_refused_;
+    last_refused_ = entry;
+  }
+}
+
+void EventStore::Load(long long entry, Chain& chain) const {
+  auto it = index_.find(entry);
+  if (it == index_.end()) {
+    throw std::runtime_error("EventStore::Load - entry " + std::to_string(entry) + " is not stored");
+  }
+  auto& stored = entries_.at(it->second);
+  TBufferFile buffer(TBuffer::kRead, static_cast<Int_t>(stored.size()), const_cast<char*>(stored.data()), kFALSE);
+  for (const auto& name : branch_names_) {
+    ANALYSISTREE_UTILS_VISIT(stream_object_struct(buffer), chain.GetPointerToBranch(name));
+  }
+  for (const auto& name : match_names_) {
+    buffer.StreamObject(chain.GetMatchPointers().at(name), Matching::Class());// index of matches is rebuilt by the read rule
+  }
+}
+
+size_t EventStore::GetMemorySize(const BranchPointer& object) {
+  return ANALYSISTREE_UTILS_VISIT(get_memory_size_struct(), object);
+}
+
+size_t EventStore::GetMemorySize(const Matching& matching) {
+  const auto& direct = matching.GetMatchPairs(false);
+  const auto& inverted = matching.GetMatchPairs(true);
+  size_t result = sizeof(matching) + (direct.capacity() + inverted.capacity()) * sizeof(Matching::PairsType::value_type);
+  // transient index vectors, sized by the largest id, pairs are sorted by id
+  if (!direct.empty()) result += (direct.back().first + 1) * sizeof(Integer_t);
+  if (!inverted.empty()) result += (inverted.back().first + 1) * sizeof(Integer_t);
+  return result;
+}
+
+void EventStore::Print(std::ostream& out) const {
+  out << "EventStore: " << entries_.size() << " entries, " << branch_names_.size() << " branches and "
+      << match_names_.size() << " matchings, " << memory_usage_ / 1024. / 1024. << " MB";
+  if (!entries_.empty()) {
+    out << " (" << memory_usage_ / entries_.size() / 1024. << " kB per entry)";
+  }
+  if (memory_limit_ > 0) {
+    out << ", limit " << memory_limit_ / 1024. / 1024. << " MB";
+  }
+  out << "\n";
+  if (n_refused_ > 0) {
+    out << "EventStore: " << n_refused_ << " entries starting from " << first_refused_
+        << " are refused because of the memory limit and read from the input\n";
+  }
+}
+
+}// namespace AnalysisTree
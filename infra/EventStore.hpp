@@ -0,0 +1,83 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_EVENTSTORE_HPP_
+#define ANALYSISTREE_INFRA_EVENTSTORE_HPP_
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <TBufferFile.h>
+
+#include "Chain.hpp"
+#include "Matching.hpp"
+
+namespace AnalysisTree {
+
+/**
+ * @brief EventStore keeps the loaded branches and matchings of a Chain in memory, so that later passes over the same
+ * entries do not read and decompress the input again. Every entry is streamed (uncompressed) into one contiguous buffer,
+ * so that it takes about as much memory as its objects in the input file, without per-channel allocations.
+ * Entries are added with Add() while the Chain is read, and streamed back into objects of the Chain with Load().
+ * If the memory limit is reached, the entry and all further entries are refused: they are not stored and should be read
+ * from the input. Each refused entry is counted once, however many times it is passed to Add()
+ */
+class EventStore {
+
+ public:
+  /**
+   * @param memory_limit maximum size of stored objects in bytes, 0 means no limit
+   */
+  explicit EventStore(size_t memory_limit = 0) : memory_limit_(memory_limit) {}
+  EventStore(const EventStore&) = delete;
+  EventStore& operator=(const EventStore&) = delete;
+  virtual ~EventStore();
+
+  /**
+   * @brief Stores objects of the chain as entry. All entries should have the same set of branches and matchings
+   * @return false if the entry is refused because of the memory limit
+   */
+  bool Add(long long entry, const Chain& chain);
+
+  /**
+   * @brief Reads stored entry into objects of the chain
+   */
+  void Load(long long entry, Chain& chain) const;
+
+  ANALYSISTREE_ATTR_NODISCARD bool Contains(long long entry) const { return index_.count(entry) != 0; }
+  ANALYSISTREE_ATTR_NODISCARD size_t GetNumberOfEntries() const { return entries_.size(); }
+  ANALYSISTREE_ATTR_NODISCARD size_t GetNumberOfRefused() const { return n_refused_; }
+  ANALYSISTREE_ATTR_NODISCARD size_t GetMemoryUsage() const { return memory_usage_; }
+  ANALYSISTREE_ATTR_NODISCARD size_t GetMemoryLimit() const { return memory_limit_; }
+  ANALYSISTREE_ATTR_NODISCARD bool IsFull() const { return n_refused_ > 0; }
+
+  void Clear();
+  void Print(std::ostream& out = std::cout) const;
+
+  /**
+   * @brief Approximate size of the object in memory, including content of its vectors
+   */
+  static size_t GetMemorySize(const BranchPointer& object);
+  static size_t GetMemorySize(const Matching& matching);
+
+ private:
+  void Refuse(long long entry);
+
+  std::vector<std::string> branch_names_{};
+  std::vector<std::string> match_names_{};
+  std::vector<std::vector<char>> entries_{};///< streamed branches in the order of branch_names_, then matchings in the order of match_names_
+  std::unordered_map<long long, size_t> index_{};///< entry number -> position in entries_
+  TBufferFile buffer_{TBuffer::kWrite};          ///< reused by Add()
+
+  size_t memory_limit_{0};
+  size_t memory_usage_{0};
+  size_t n_refused_{0};
+  long long first_refused_{-1};
+  long long last_refused_{-1};
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_INFRA_EVENTSTORE_HPP_
@@ -0,0 +1,398 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include "Expression.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace AnalysisTree {
+
+namespace {
+
+template<typename Function>
+void ApplyUnary(double* a, size_t n, Function function) {
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = function(a[i]);
+  }
+}
+
+template<typename Function>
+void ApplyBinary(double* a, const double* b, size_t n, Function function) {
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = function(a[i], b[i]);
+  }
+}
+
+}// namespace
+
+/**
+ * @brief Recursive descent parser, emits bytecode in postfix order and builds the canonical form of each sub-expression
+ */
+class Expression::Parser {
+
+ public:
+  Parser(const std::string& formula, Expression& expression) : formula_(formula), expression_(expression) {}
+
+  std::string Parse() {
+    auto result = ParseOr();
+    SkipSpaces();
+    if (pos_ != formula_.size()) {
+      Error("unexpected symbol '" + formula_.substr(pos_, 1) + "'");
+    }
+    return result;
+  }
+
+ private:
+  std::string ParseOr() {
+    auto result = ParseAnd();
+    while (Accept("||")) {
+      result = Emit(eOp::kOr, result, "||", ParseAnd());
+    }
+    return result;
+  }
+
+  std::string ParseAnd() {
+    auto result = ParseComparison();
+    while (Accept("&&")) {
+      result = Emit(eOp::kAnd, result, "&&", ParseComparison());
+    }
+    return result;
+  }
+
+  std::string ParseComparison() {
+    auto result = ParseSum();
+    while (true) {
+      if (Accept("==")) {
+        result = Emit(eOp::kEqual, result, "==", ParseSum());
+      } else if (Accept("!=")) {
+        result = Emit(eOp::kNotEqual, result, "!=", ParseSum());
+      } else if (Accept("<=")) {
+        result = Emit(eOp::kLessEq, result, "<=", ParseSum());
+      } else if (Accept(">=")) {
+        result = Emit(eOp::kGreaterEq, result, ">=", ParseSum());
+      } else if (Accept("<")) {
+        result = Emit(eOp::kLess, result, "<", ParseSum());
+      } else if (Accept(">")) {
+        result = Emit(eOp::kGreater, result, ">", ParseSum());
+      } else {
+        return result;
+      }
+    }
+  }
+
+  std::string ParseSum() {
+    auto result = ParseProduct();
+    while (true) {
+      if (Accept("+")) {
+        result = Emit(eOp::kAdd, result, "+", ParseProduct());
+      } else if (Accept("-")) {
+        result = Emit(eOp::kSub, result, "-", ParseProduct());
+      } else {
+        return result;
+      }
+    }
+  }
+
+  std::string ParseProduct() {
+    auto result = ParseUnary();
+    while (true) {
+      if (Accept("*")) {
+        result = Emit(eOp::kMul, result, "*", ParseUnary());
+      } else if (Accept("/")) {
+        result = Emit(eOp::kDiv, result, "/", ParseUnary());
+      } else {
+        return result;
+      }
+    }
+  }
+
+  std::string ParseUnary() {
+    if (Accept("-")) {
+      auto arg = ParseUnary();
+      Emit(eOp::kNeg);
+      return "(-" + arg + ")";
+    }
+    if (Accept("!")) {
+      auto arg = ParseUnary();
+      Emit(eOp::kNot);
+      return "(!" + arg + ")";
+    }
+    return ParsePower();
+  }
+
+  std::string ParsePower() {
+    auto result = ParsePrimary();
+    if (Accept("^")) {
+      result = Emit(eOp::kPow, result, "^", ParseUnary());
+    }
+    return result;
+  }
+
+  std::string ParsePrimary() {
+    SkipSpaces();
+    if (pos_ == formula_.size()) {
+      Error("unexpected end of expression");
+    }
+    if (Accept("(")) {
+      auto result = ParseOr();
+      Expect(")");
+      return result;
+    }
+    const char c = formula_[pos_];
+    if (std::isdigit(c) || c == '.') {
+      return ParseNumber();
+    }
+    if (std::isalpha(c) || c == '_') {
+      return ParseName();
+    }
+    Error("unexpected symbol '" + std::string(1, c) + "'");
+    return {};
+  }
+
+  std::string ParseNumber() {
+    const char* begin = formula_.c_str() + pos_;
+    char* end{nullptr};
+    const double value = std::strtod(begin, &end);
+    if (end == begin) {
+      Error("wrong number");
+    }
+    pos_ += end - begin;
+    expression_.code_.push_back({eOp::kConst, value, 0});
+    std::ostringstream out;
+    out.precision(15);
+    out << value;
+    return out.str();
+  }
+
+  std::string ParseName() {
+    auto name = ReadIdentifier();
+    if (pos_ < formula_.size() && formula_[pos_] == '.') {// field
+      ++pos_;
+      const auto field = ReadIdentifier();
+      if (field.empty()) {
+        Error("field name is expected after '" + name + ".'");
+      }
+      name += "." + field;
+      auto& names = expression_.field_names_;
+      auto it = std::find(names.begin(), names.end(), name);
+      if (it == names.end()) {
+        it = names.insert(names.end(), name);
+      }
+      expression_.code_.push_back({eOp::kField, 0., static_cast<size_t>(std::distance(names.begin(), it))});
+      return name;
+    }
+
+    static const std::map<std::string, eOp> functions{
+        {"sqrt", eOp::kSqrt}, {"abs", eOp::kAbs}, {"exp", eOp::kExp}, {"log", eOp::kLog}, {"log10", eOp::kLog10}, {"sin", eOp::kSin}, {"cos", eOp::kCos}, {"tan", eOp::kTan}, {"asin", eOp::kAsin}, {"acos", eOp::kAcos}, {"atan", eOp::kAtan}, {"atan2", eOp::kAtan2}, {"pow", eOp::kPow}, {"min", eOp::kMin}, {"max", eOp::kMax}};
+    auto function = functions.find(name);
+    if (function == functions.end()) {
+      Error("unknown function '" + name + "', fields must be given as <branch>.<field>");
+    }
+    Expect("(");
+    std::string args = ParseOr();
+    for (int i = 1; i < GetNumberOfOperands(function->second); ++i) {
+      Expect(",");
+      args += "," + ParseOr();
+    }
+    Expect(")");
+    Emit(function->second);
+    return name + "(" + args + ")";
+  }
+
+  std::string ReadIdentifier() {
+    const auto begin = pos_;
+    while (pos_ < formula_.size() && (std::isalnum(formula_[pos_]) || formula_[pos_] == '_')) {
+      ++pos_;
+    }
+    return formula_.substr(begin, pos_ - begin);
+  }
+
+  std::string Emit(eOp op, const std::string& lhs, const std::string& symbol, const std::string& rhs) {
+    Emit(op);
+    return "(" + lhs + symbol + rhs + ")";
+  }
+
+  void Emit(eOp op) { expression_.code_.push_back({op, 0., 0}); }
+
+  void SkipSpaces() {
+    while (pos_ < formula_.size() && std::isspace(formula_[pos_])) {
+      ++pos_;
+    }
+  }
+
+  bool Accept(const std::string& token) {
+    SkipSpaces();
+    if (formula_.compare(pos_, token.size(), token) != 0) {
+      return false;
+    }
+    // do not take "<" from "<=" or "!" from "!="
+    if (token.size() == 1 && pos_ + 1 < formula_.size() && formula_[pos_ + 1] == '=' && std::string("<>!=").find(token) != std::string::npos) {
+      return false;
+    }
+    pos_ += token.size();
+    return true;
+  }
+
+  void Expect(const std::string& token) {
+    if (!Accept(token)) {
+      Error("'" + token + "' is expected");
+    }
+  }
+
+  void Error(const std::string& message) const {
+    throw std::runtime_error("Expression - " + message + " at position " + std::to_string(pos_) + " in \"" + formula_ + "\"");
+  }
+
+  const std::string& formula_;
+  Expression& expression_;
+  size_t pos_{0};
+};
+
+Expression::Expression(const std::string& formula) {
+  canonical_ = Parser(formula, *this).Parse();
+  hash_ = std::hash<std::string>()(canonical_);
+
+  size_t depth{0};
+  for (const auto& instruction : code_) {
+    depth = depth + 1 - GetNumberOfOperands(instruction.op);
+    max_depth_ = std::max(max_depth_, depth);
+  }
+}
+
+int Expression::GetNumberOfOperands(eOp op) {
+  switch (op) {
+    case eOp::kConst:
+    case eOp::kField: return 0;
+    case eOp::kNeg:
+    case eOp::kNot:
+    case eOp::kSqrt:
+    case eOp::kAbs:
+    case eOp::kExp:
+    case eOp::kLog:
+    case eOp::kLog10:
+    case eOp::kSin:
+    case eOp::kCos:
+    case eOp::kTan:
+    case eOp::kAsin:
+    case eOp::kAcos:
+    case eOp::kAtan: return 1;
+    default: return 2;
+  }
+}
+
+double Expression::Unary(eOp op, double a) {
+  switch (op) {
+    case eOp::kNeg: return -a;
+    case eOp::kNot: return a == 0.;
+    case eOp::kSqrt: return std::sqrt(a);
+    case eOp::kAbs: return std::fabs(a);
+    case eOp::kExp: return std::exp(a);
+    case eOp::kLog: return std::log(a);
+    case eOp::kLog10: return std::log10(a);
+    case eOp::kSin: return std::sin(a);
+    case eOp::kCos: return std::cos(a);
+    case eOp::kTan: return std::tan(a);
+    case eOp::kAsin: return std::asin(a);
+    case eOp::kAcos: return std::acos(a);
+    case eOp::kAtan: return std::atan(a);
+    default: throw std::runtime_error("Expression::Unary - not a unary operation");
+  }
+}
+
+double Expression::Binary(eOp op, double a, double b) {
+  switch (op) {
+    case eOp::kAdd: return a + b;
+    case eOp::kSub: return a - b;
+    case eOp::kMul: return a * b;
+    case eOp::kDiv: return a / b;
+    case eOp::kPow: return std::pow(a, b);
+    case eOp::kLess: return a < b;
+    case eOp::kLessEq: return a <= b;
+    case eOp::kGreater: return a > b;
+    case eOp::kGreaterEq: return a >= b;
+    case eOp::kEqual: return std::fabs(a - b) <= SmallNumber;
+    case eOp::kNotEqual: return std::fabs(a - b) > SmallNumber;
+    case eOp::kAnd: return a != 0. && b != 0.;
+    case eOp::kOr: return a != 0. || b != 0.;
+    case eOp::kAtan2: return std::atan2(a, b);
+    case eOp::kMin: return std::min(a, b);
+    case eOp::kMax: return std::max(a, b);
+    default: throw std::runtime_error("Expression::Binary - not a binary operation");
+  }
+}
+
+double Expression::Evaluate(const std::vector<double>& args) const {
+  if (code_.empty()) {
+    throw std::runtime_error("Expression::Evaluate - expression is empty");
+  }
+  stack_.resize(max_depth_);
+  size_t top{0};// number of values in the stack
+  for (const auto& instruction : code_) {
+    switch (GetNumberOfOperands(instruction.op)) {
+      case 0:
+        stack_[top++] = instruction.op == eOp::kConst ? instruction.value : args[instruction.index];
+        break;
+      case 1:
+        stack_[top - 1] = Unary(instruction.op, stack_[top - 1]);
+        break;
+      default:
+        stack_[top - 2] = Binary(instruction.op, stack_[top - 2], stack_[top - 1]);
+        --top;
+    }
+  }
+  return stack_[0];
+}
+
+/**
+ * Each instruction is applied to the whole batch, so the loops in ApplyUnary() and ApplyBinary()
+ * have no branches and can be vectorized by the compiler
+ */
+void Expression::EvaluateBatch(const double* columns, size_t n, double* out) const {
+  if (code_.empty()) {
+    throw std::runtime_error("Expression::EvaluateBatch - expression is empty");
+  }
+  stack_.resize(max_depth_ * n);
+  size_t top{0};
+  for (const auto& instruction : code_) {
+    const auto op = instruction.op;
+    double* a = stack_.data() + (top - GetNumberOfOperands(op)) * n;// first operand and result
+    const double* b = a + n;                                          // second operand
+    switch (op) {
+      case eOp::kConst: std::fill(a, a + n, instruction.value); break;
+      case eOp::kField: std::copy(columns + instruction.index * n, columns + (instruction.index + 1) * n, a); break;
+      case eOp::kNeg: ApplyUnary(a, n, [](double x) { return -x; }); break;
+      case eOp::kNot: ApplyUnary(a, n, [](double x) { return double(x == 0.); }); break;
+      case eOp::kSqrt: ApplyUnary(a, n, [](double x) { return std::sqrt(x); }); break;
+      case eOp::kAbs: ApplyUnary(a, n, [](double x) { return std::fabs(x); }); break;
+      case eOp::kAdd: ApplyBinary(a, b, n, [](double x, double y) { return x + y; }); break;
+      case eOp::kSub: ApplyBinary(a, b, n, [](double x, double y) { return x - y; }); break;
+      case eOp::kMul: ApplyBinary(a, b, n, [](double x, double y) { return x * y; }); break;
+      case eOp::kDiv: ApplyBinary(a, b, n, [](double x, double y) { return x / y; }); break;
+      case eOp::kLess: ApplyBinary(a, b, n, [](double x, double y) { return double(x < y); }); break;
+      case eOp::kLessEq: ApplyBinary(a, b, n, [](double x, double y) { return double(x <= y); }); break;
+      case eOp::kGreater: ApplyBinary(a, b, n, [](double x, double y) { return double(x > y); }); break;
+      case eOp::kGreaterEq: ApplyBinary(a, b, n, [](double x, double y) { return double(x >= y); }); break;
+      case eOp::kAnd: ApplyBinary(a, b, n, [](double x, double y) { return double((x != 0.) & (y != 0.)); }); break;
+      case eOp::kOr: ApplyBinary(a, b, n, [](double x, double y) { return double((x != 0.) | (y != 0.)); }); break;
+      case eOp::kMin: ApplyBinary(a, b, n, [](double x, double y) { return x < y ? x : y; }); break;
+      case eOp::kMax: ApplyBinary(a, b, n, [](double x, double y) { return x > y ? x : y; }); break;
+      default:
+        if (GetNumberOfOperands(op) == 1) {
+          ApplyUnary(a, n, [op](double x) { return Unary(op, x); });
+        } else {
+          ApplyBinary(a, b, n, [op](double x, double y) { return Binary(op, x, y); });
+        }
+    }
+    top = top + 1 - GetNumberOfOperands(op);
+  }
+  std::copy(stack_.begin(), stack_.begin() + n, out);
+}
+
+}// namespace AnalysisTree
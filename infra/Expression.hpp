@@ -0,0 +1,125 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_EXPRESSION_HPP_
+#define ANALYSISTREE_INFRA_EXPRESSION_HPP_
+
+#include <string>
+#include <vector>
+
+#include "Constants.hpp"
+
+namespace AnalysisTree {
+
+/**
+ * @brief Expression is an arithmetic or logical formula of fields, e.g.
+ * "sqrt(VtxTracks.px^2 + VtxTracks.py^2) > 0.2 && VtxTracks.nhits >= 4".
+ * The formula is compiled once into a stack bytecode, which is evaluated either for one set of arguments
+ * or for a batch of channels, instruction by instruction over the whole batch.
+ *
+ * Supported syntax (in order of increasing precedence):
+ *  - logical: ||, &&
+ *  - comparison: ==, !=, <, <=, >, >= (== and != compare with SmallNumber tolerance, as EqualsCut)
+ *  - arithmetic: +, -, *, /, ^ (power, right-associative), unary - and !
+ *  - functions: sqrt, abs, exp, log, log10, sin, cos, tan, asin, acos, atan, atan2, pow, min, max
+ *  - numbers and fields in format "branch.field"
+ * Logical and comparison operators return 1 or 0.
+ */
+class Expression {
+
+ public:
+  Expression() = default;
+  explicit Expression(const std::string& formula);
+  Expression(const Expression&) = default;
+  Expression(Expression&&) = default;
+  Expression& operator=(Expression&&) = default;
+  Expression& operator=(const Expression&) = default;
+  virtual ~Expression() = default;
+
+  /**
+   * @brief Evaluates Expression
+   * @param args values of fields in the order of GetFieldNames()
+   */
+  double Evaluate(const std::vector<double>& args) const;
+
+  /**
+   * @brief Evaluates Expression for n channels at once
+   * @param columns values of fields, field-major: columns[i_field * n + i_channel]
+   * @param out results are written to out[0] ... out[n - 1]
+   */
+  void EvaluateBatch(const double* columns, size_t n, double* out) const;
+
+  /**
+   * @return names of fields ("branch.field") in order of their first appearance, each name only once
+   */
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<std::string>& GetFieldNames() const { return field_names_; }
+
+  /**
+   * @return normalized formula: white spaces removed, all operations in brackets, numbers in one format.
+   * Formulas which differ only in formatting have the same canonical form
+   */
+  ANALYSISTREE_ATTR_NODISCARD const std::string& GetCanonical() const { return canonical_; }
+  ANALYSISTREE_ATTR_NODISCARD size_t GetHash() const { return hash_; }
+  ANALYSISTREE_ATTR_NODISCARD bool IsEmpty() const { return code_.empty(); }
+
+  friend bool operator==(const Expression& that, const Expression& other) { return that.canonical_ == other.canonical_; }
+
+ private:
+  enum class eOp : short {
+    kConst = 0,
+    kField,
+    kNeg,
+    kNot,
+    kAdd,
+    kSub,
+    kMul,
+    kDiv,
+    kPow,
+    kLess,
+    kLessEq,
+    kGreater,
+    kGreaterEq,
+    kEqual,
+    kNotEqual,
+    kAnd,
+    kOr,
+    kSqrt,
+    kAbs,
+    kExp,
+    kLog,
+    kLog10,
+    kSin,
+    kCos,
+    kTan,
+    kAsin,
+    kAcos,
+    kAtan,
+    kAtan2,
+    kMin,
+    kMax
+  };
+
+  struct Instruction {
+    eOp op{eOp::kConst};
+    double value{0.};///< constant for kConst
+    size_t index{0}; ///< field index for kField
+  };
+
+  class Parser;
+
+  static int GetNumberOfOperands(eOp op);
+  static double Unary(eOp op, double a);
+  static double Binary(eOp op, double a, double b);
+
+  std::vector<Instruction> code_{};
+  std::vector<std::string> field_names_{};
+  std::string canonical_{};
+  size_t hash_{0};
+  size_t max_depth_{0};
+
+  mutable std::vector<double> stack_{};//! scratch for evaluation
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_INFRA_EXPRESSION_HPP_
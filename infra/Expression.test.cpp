@@ -0,0 +1,96 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_EXPRESSION_TEST_CPP_
+#define ANALYSISTREE_INFRA_EXPRESSION_TEST_CPP_
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include <core/Configuration.hpp>
+#include <core/Track.hpp>
+#include <infra/Branch.hpp>
+#include <infra/Cuts.hpp>
+#include <infra/Expression.hpp>
+#include <infra/Variable.hpp>
+
+namespace {
+
+using namespace AnalysisTree;
+
+TEST(Expression, Evaluate) {
+  Expression pt("sqrt(VtxTracks.px^2 + VtxTracks.py^2)");
+  ASSERT_EQ(pt.GetFieldNames().size(), 2);
+  EXPECT_EQ(pt.GetFieldNames().at(0), "VtxTracks.px");
+  EXPECT_FLOAT_EQ(pt.Evaluate({3., 4.}), 5.);
+
+  Expression cut("sqrt(VtxTracks.px^2+VtxTracks.py^2) > 0.2 && VtxTracks.nhits >= 4");
+  ASSERT_EQ(cut.GetFieldNames().size(), 3);
+  EXPECT_EQ(cut.Evaluate({0.3, 0., 4.}), 1.);
+  EXPECT_EQ(cut.Evaluate({0.1, 0., 4.}), 0.);
+  EXPECT_EQ(cut.Evaluate({0.3, 0., 3.}), 0.);
+
+  EXPECT_FLOAT_EQ(Expression("-2^2 + 10 / 4 * 2").Evaluate({}), 1.);
+  EXPECT_FLOAT_EQ(Expression("2^3^2").Evaluate({}), 512.);
+  EXPECT_FLOAT_EQ(Expression("max(1, min(5, 3)) - atan2(0, 1)").Evaluate({}), 3.);
+  EXPECT_EQ(Expression("!(1 < 2) || 3 != 3").Evaluate({}), 0.);
+
+  EXPECT_THROW(Expression("VtxTracks.px +"), std::runtime_error);
+  EXPECT_THROW(Expression("px > 1"), std::runtime_error);
+  EXPECT_THROW(Expression("sqrt(VtxTracks.px"), std::runtime_error);
+}
+
+TEST(Expression, Canonical) {
+  Expression a("sqrt(VtxTracks.px^2+VtxTracks.py^2) > 0.2");
+  Expression b("sqrt( VtxTracks.px ^ 2 + VtxTracks.py ^ 2 )>0.20");
+  Expression c("sqrt(VtxTracks.px^2+VtxTracks.py^2) > 0.3");
+  EXPECT_EQ(a.GetCanonical(), b.GetCanonical());
+  EXPECT_EQ(a.GetHash(), b.GetHash());
+  EXPECT_TRUE(a == b);
+  EXPECT_FALSE(a == c);
+
+  EXPECT_TRUE(Variable::FromExpression("VtxTracks.px * 2") == Variable::FromExpression("VtxTracks.px*2"));
+  EXPECT_TRUE(ExpressionCut("VtxTracks.px > 1") == ExpressionCut("VtxTracks.px>1"));
+  EXPECT_FALSE(ExpressionCut("VtxTracks.px > 1") == ExpressionCut("VtxTracks.px > 2"));
+}
+
+TEST(Expression, Batch) {
+  BranchConfig config("VtxTracks", DetType::kTrack);
+  config.AddField<int>("nhits", "");
+  Configuration conf;
+  conf.AddBranchConfig(config);
+
+  auto* tracks = new TrackDetector(config.GetId());
+  for (int i = 0; i < 50; ++i) {
+    auto& track = tracks->AddChannel(config);
+    track.SetMomentum(0.01f * i, 0.02f * i, 1.f);
+    track.SetField(i % 8, config.GetFieldId("nhits"));
+  }
+  Branch branch(config, tracks);
+
+  auto var = Variable::FromExpression("sqrt(VtxTracks.px^2 + VtxTracks.py^2)");
+  var.Init(conf);
+  Field pt("VtxTracks", "pT");
+  pt.Init(conf);
+  std::vector<double> values(tracks->GetNumberOfChannels());
+  var.GetValues(branch, 0, values.size(), values.data());
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_FLOAT_EQ(values[i], branch[i][pt]) << "channel " << i;
+  }
+
+  Cuts cuts("cuts", {ExpressionCut("sqrt(VtxTracks.px^2+VtxTracks.py^2) > 0.2 && VtxTracks.nhits >= 4")});
+  cuts.Init(conf);
+  const auto mask = cuts.ApplyBatch(branch);
+  for (size_t i = 0; i < mask.size(); ++i) {
+    EXPECT_EQ(bool(mask[i]), cuts.Apply(branch[i])) << "channel " << i;
+  }
+  EXPECT_TRUE(mask[12]);
+  EXPECT_FALSE(mask[11]);
+  EXPECT_FALSE(mask[16]);
+}
+
+}// namespace
+
+#endif//ANALYSISTREE_INFRA_EXPRESSION_TEST_CPP_
@@ -9,6 +9,7 @@
 #include <string>
 
 #include "Constants.hpp"
+#include "FieldHandle.hpp"
 #include "Utils.hpp"
 
 namespace AnalysisTree {
@@ -65,13 +66,29 @@ class Field {
       throw std::runtime_error("Field::Fill - Field " + field_ + " is not initialized");
     }
     switch (field_type_) {
-      case Types::kFloat: return object.template GetField<float>(field_id_);
-      case (Types::kInteger): return object.template GetField<int>(field_id_);
-      case Types::kBool: return object.template GetField<bool>(field_id_);
-      default: throw std::runtime_error("Unknown field type");
+      case Types::kFloat: return FieldHandle<float, T>::Read(object, field_id_);
+      case (Types::kInteger): return FieldHandle<int, T>::Read(object, field_id_);
+      case Types::kBool: return FieldHandle<bool, T>::Read(object, field_id_);
+      default: {
+        if (field_ == "ones") return 1;
+        throw std::runtime_error("Unknown field type");
+      }
     }
   }
 
+  /**
+   * @brief Returns typed accessor of the field for objects of type Entity, without per-call dispatch, see FieldHandle
+   * @tparam T float, int or bool, should be the type of the field, unless it is a default one
+   * @tparam Entity Track, Particle, Hit, Module, EventHeader or Container
+   */
+  template<typename T, typename Entity>
+  ANALYSISTREE_ATTR_NODISCARD FieldHandle<T, Entity> GetHandle() const {
+    if (!is_init_) {
+      throw std::runtime_error("Field::GetHandle - Field " + field_ + " is not initialized");
+    }
+    return {field_, branch_type_, field_id_, field_type_};
+  }
+
   void Print() const;
 
   ANALYSISTREE_ATTR_NODISCARD const Branch* GetParentBranch() const { return parent_branch_; }
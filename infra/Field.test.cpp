@@ -10,6 +10,7 @@
 
 #include <core/BranchConfig.hpp>
 #include <core/Configuration.hpp>
+#include <core/Particle.hpp>
 #include <core/Track.hpp>
 
 namespace {
@@ -54,6 +55,69 @@ TEST(Field, Basics) {
   EXPECT_EQ(true, field_b.GetValue(track));
 }
 
+TEST(Field, Handle) {
+
+  BranchConfig branch_config("RecTrack", DetType::kTrack);
+  branch_config.AddField<float>("test_f", "test field");
+  branch_config.AddField<int>("test_i", "test field");
+
+  Configuration configuration;
+  configuration.AddBranchConfig(branch_config);
+
+  Field field_f("RecTrack", "test_f");
+  Field field_i("RecTrack", "test_i");
+  Field field_px("RecTrack", "px");
+  Field field_pt("RecTrack", "pT");
+  Field field_ones("RecTrack", "ones");
+  for (auto* field : {&field_f, &field_i, &field_px, &field_pt, &field_ones}) {
+    field->Init(configuration);
+  }
+
+  EXPECT_ANY_THROW(((void) Field("RecTrack", "test_f").GetHandle<float, Track>()));// not initialized
+  EXPECT_ANY_THROW(((void) field_f.GetHandle<int, Track>()));                      // wrong type
+  EXPECT_ANY_THROW(((void) field_f.GetHandle<float, Particle>()));                 // wrong type of objects
+
+  const auto handle_f = field_f.GetHandle<float, Track>();
+  const auto handle_i = field_i.GetHandle<int, Track>();
+  const auto handle_px = field_px.GetHandle<float, Track>();
+  const auto handle_pt = field_pt.GetHandle<float, Track>();
+  const auto handle_ones = field_ones.GetHandle<float, Track>();
+
+  Track track;
+  track.Init(branch_config);
+  handle_f.Set(track, 1.5f);
+  handle_i.Set(track, 7);
+  handle_px.Set(track, 3.f);
+  track.SetMomentum(3.f, 4.f, 0.f);
+
+  EXPECT_FLOAT_EQ(handle_f(track), 1.5f);
+  EXPECT_EQ(handle_i(track), 7);
+  EXPECT_FLOAT_EQ(handle_px(track), 3.f);
+  EXPECT_FLOAT_EQ(handle_pt(track), 5.f);
+  EXPECT_FLOAT_EQ(handle_ones(track), 1.f);
+  EXPECT_ANY_THROW(handle_ones.Set(track, 2.f));
+
+  EXPECT_FLOAT_EQ(field_f.GetValue(track), handle_f(track));// Field is read in the same way
+  EXPECT_FLOAT_EQ(field_pt.GetValue(track), handle_pt(track));
+  EXPECT_FLOAT_EQ(field_ones.GetValue(track), 1.f);
+}
+
+TEST(Field, HandleDefaultFields) {
+  Particle particle;
+  particle.SetMomentum(0.3f, -0.4f, 1.2f);
+  particle.SetPid(211);
+
+  for (Integer_t id = ParticleFields::kId; id < 0; ++id) {// every default field has its own getter
+    const FieldHandle<float, Particle> handle("field", DetType::kParticle, id, Types::kFloat);
+    EXPECT_FLOAT_EQ(handle(particle), particle.GetField<float>(id)) << id;
+  }
+  for (Integer_t id = TrackFields::kId; id < 0; ++id) {
+    const FieldHandle<float, Track> handle("field", DetType::kTrack, id, Types::kFloat);
+    EXPECT_FLOAT_EQ(handle(particle), static_cast<const Track&>(particle).GetField<float>(id)) << id;
+  }
+  EXPECT_ANY_THROW((FieldHandle<float, Track>("field", DetType::kTrack, TrackFields::kId - 1, Types::kFloat)));
+}
+
 }// namespace
 
 #endif//ANALYSISTREE_INFRA_FIELD_TEST_HPP_
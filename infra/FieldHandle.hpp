@@ -0,0 +1,259 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_FIELDHANDLE_HPP_
+#define ANALYSISTREE_INFRA_FIELDHANDLE_HPP_
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "Constants.hpp"
+#include "EventHeader.hpp"
+#include "Hit.hpp"
+#include "Module.hpp"
+#include "Particle.hpp"
+#include "Track.hpp"
+
+#if defined(DEBUG) && !defined(ANALYSISTREE_FIELD_CHECKS)
+#define ANALYSISTREE_FIELD_CHECKS
+#endif
+
+namespace AnalysisTree {
+
+namespace Utils {
+template<typename Entity>
+struct EntityDetType;
+template<>
+struct EntityDetType<Track> { static constexpr DetType value = DetType::kTrack; };
+template<>
+struct EntityDetType<Particle> { static constexpr DetType value = DetType::kParticle; };
+template<>
+struct EntityDetType<Hit> { static constexpr DetType value = DetType::kHit; };
+template<>
+struct EntityDetType<Module> { static constexpr DetType value = DetType::kModule; };
+template<>
+struct EntityDetType<EventHeader> { static constexpr DetType value = DetType::kEventHeader; };
+template<>
+struct EntityDetType<Container> { static constexpr DetType value = DetType::kGeneric; };
+
+template<typename T>
+constexpr Types FieldType();
+template<>
+constexpr Types FieldType<float>() { return Types::kFloat; }
+template<>
+constexpr Types FieldType<int>() { return Types::kInteger; }
+template<>
+constexpr Types FieldType<bool>() { return Types::kBool; }
+
+/**
+ * @brief Getters of default fields of Entity, one function per field id. The id is resolved once, when FieldHandle
+ * is created, so reading does not go through the switch of Entity::GetField()
+ * @return getter of the field or nullptr if field_id is not a default field of Entity
+ */
+template<typename T, typename Entity>
+struct DefaultFieldGetter {
+  static T (*Get(Integer_t))(const Entity&) { return nullptr; }
+};
+template<typename T>
+struct DefaultFieldGetter<T, Track> {
+  static T (*Get(Integer_t field_id))(const Track&) {
+    switch (field_id) {
+      case TrackFields::kPhi: return [](const Track& t) { return static_cast<T>(t.GetPhi()); };
+      case TrackFields::kPt: return [](const Track& t) { return static_cast<T>(t.GetPt()); };
+      case TrackFields::kEta: return [](const Track& t) { return static_cast<T>(t.GetEta()); };
+      case TrackFields::kP: return [](const Track& t) { return static_cast<T>(t.GetP()); };
+      case TrackFields::kPx: return [](const Track& t) { return static_cast<T>(t.GetPx()); };
+      case TrackFields::kPy: return [](const Track& t) { return static_cast<T>(t.GetPy()); };
+      case TrackFields::kPz: return [](const Track& t) { return static_cast<T>(t.GetPz()); };
+      case TrackFields::kQ: return [](const Track& t) { return static_cast<T>(t.GetCharge()); };
+      case TrackFields::kId: return [](const Track& t) { return static_cast<T>(t.GetId()); };
+      default: return nullptr;
+    }
+  }
+};
+template<typename T>
+struct DefaultFieldGetter<T, Particle> {
+  static T (*Get(Integer_t field_id))(const Particle&) {
+    switch (field_id) {
+      case ParticleFields::kPhi: return [](const Particle& p) { return static_cast<T>(p.GetPhi()); };
+      case ParticleFields::kPt: return [](const Particle& p) { return static_cast<T>(p.GetPt()); };
+      case ParticleFields::kRapidity: return [](const Particle& p) { return static_cast<T>(p.GetRapidity()); };
+      case ParticleFields::kPid: return [](const Particle& p) { return static_cast<T>(p.GetPid()); };
+      case ParticleFields::kMass: return [](const Particle& p) { return static_cast<T>(p.GetMass()); };
+      case ParticleFields::kEta: return [](const Particle& p) { return static_cast<T>(p.GetEta()); };
+      case ParticleFields::kP: return [](const Particle& p) { return static_cast<T>(p.GetP()); };
+      case ParticleFields::kEnergy: return [](const Particle& p) { return static_cast<T>(p.GetEnergy()); };
+      case ParticleFields::kKineticEnergy: return [](const Particle& p) { return static_cast<T>(p.GetKineticEnergy()); };
+      case ParticleFields::kPx: return [](const Particle& p) { return static_cast<T>(p.GetPx()); };
+      case ParticleFields::kPy: return [](const Particle& p) { return static_cast<T>(p.GetPy()); };
+      case ParticleFields::kPz: return [](const Particle& p) { return static_cast<T>(p.GetPz()); };
+      case ParticleFields::kQ: return [](const Particle& p) { return static_cast<T>(p.GetCharge()); };
+      case ParticleFields::kId: return [](const Particle& p) { return static_cast<T>(p.GetId()); };
+      default: return nullptr;
+    }
+  }
+};
+template<typename T>
+struct DefaultFieldGetter<T, Hit> {
+  static T (*Get(Integer_t field_id))(const Hit&) {
+    switch (field_id) {
+      case HitFields::kX: return [](const Hit& h) { return static_cast<T>(h.GetX()); };
+      case HitFields::kY: return [](const Hit& h) { return static_cast<T>(h.GetY()); };
+      case HitFields::kZ: return [](const Hit& h) { return static_cast<T>(h.GetZ()); };
+      case HitFields::kPhi: return [](const Hit& h) { return static_cast<T>(h.GetPhi()); };
+      case HitFields::kSignal: return [](const Hit& h) { return static_cast<T>(h.GetSignal()); };
+      case HitFields::kId: return [](const Hit& h) { return static_cast<T>(h.GetId()); };
+      default: return nullptr;
+    }
+  }
+};
+template<typename T>
+struct DefaultFieldGetter<T, Module> {
+  static T (*Get(Integer_t field_id))(const Module&) {
+    switch (field_id) {
+      case ModuleFields::kNumber: return [](const Module& m) { return static_cast<T>(m.GetNumber()); };
+      case ModuleFields::kSignal: return [](const Module& m) { return static_cast<T>(m.GetSignal()); };
+      case ModuleFields::kId: return [](const Module& m) { return static_cast<T>(m.GetId()); };
+      default: return nullptr;
+    }
+  }
+};
+template<typename T>
+struct DefaultFieldGetter<T, EventHeader> {
+  static T (*Get(Integer_t field_id))(const EventHeader&) {
+    switch (field_id) {
+      case EventHeaderFields::kVertexX: return [](const EventHeader& e) { return static_cast<T>(e.GetVertexX()); };
+      case EventHeaderFields::kVertexY: return [](const EventHeader& e) { return static_cast<T>(e.GetVertexY()); };
+      case EventHeaderFields::kVertexZ: return [](const EventHeader& e) { return static_cast<T>(e.GetVertexZ()); };
+      case EventHeaderFields::kId: return [](const EventHeader& e) { return static_cast<T>(e.GetId()); };
+      default: return nullptr;
+    }
+  }
+};
+}// namespace Utils
+
+/**
+ * @brief Typed accessor of one field of objects of type Entity (Track, Particle, Hit, Module, EventHeader or Container
+ * for generic detectors), resolved once with Field::GetHandle(). Fields added by user are read directly from the vector
+ * of type T of the object, default fields (negative ids, e.g. px of Track) with the getter of this field selected in
+ * initialization, see Utils::DefaultFieldGetter.
+ * No variant dispatch and no bounds checks are done per call. If ANALYSISTREE_FIELD_CHECKS is defined (by default
+ * in Debug build, see DEBUG) every access is validated.
+ * @tparam T type of the field: float, int or bool. Default fields can be read as any of them
+ */
+template<typename T, typename Entity>
+class FieldHandle {
+ public:
+  FieldHandle() = default;
+
+  /**
+   * @param name name of the field, for error messages and "ones" field
+   * @param branch_type type of the branch of the field, should correspond to Entity
+   * @param field_id id of the field in BranchConfig
+   * @param field_type type of the field in BranchConfig, should be T for not default fields
+   */
+  FieldHandle(const std::string& name, DetType branch_type, Integer_t field_id, Types field_type) {
+    if (branch_type != Utils::EntityDetType<Entity>::value) {
+      throw std::runtime_error("FieldHandle - field " + name + " belongs to a branch of another type");
+    }
+    field_id_ = field_id;
+    if (name == "ones") {
+      getter_ = &FieldHandle::One;
+      setter_ = &FieldHandle::NotSettable;
+    } else if (field_id < 0) {
+      if (field_id < -kMaxDefaultFields) {
+        throw std::runtime_error("FieldHandle - field " + name + " is not found");
+      }
+      getter_ = Utils::DefaultFieldGetter<T, Entity>::Get(field_id);
+      if (getter_ == nullptr) {
+        throw std::runtime_error("FieldHandle - field " + name + " is not a default field of this type of objects");
+      }
+      setter_ = GetDefaultSetter(field_id, std::make_index_sequence<kMaxDefaultFields>());
+    } else if (field_type != Utils::FieldType<T>()) {
+      throw std::runtime_error("FieldHandle - field " + name + " has another type");
+    }
+    is_init_ = true;
+  }
+
+  ANALYSISTREE_ATTR_NODISCARD T Get(const Entity& entity) const {
+#ifdef ANALYSISTREE_FIELD_CHECKS
+    Check(entity);
+#endif
+    return getter_ != nullptr ? getter_(entity) : entity.template GetVector<T>()[field_id_];
+  }
+
+  ANALYSISTREE_ATTR_NODISCARD T operator()(const Entity& entity) const { return Get(entity); }
+
+  /**
+   * @brief Sets value of the field. Setting of calculated default fields (e.g. pT) is ignored, as in Entity::SetField().
+   * Writing is always bounds-checked
+   */
+  void Set(Entity& entity, T value) const {
+    if (!is_init_) {
+      throw std::runtime_error("FieldHandle - handle is not initialized");
+    }
+    if (setter_ != nullptr) {
+      setter_(entity, value);
+    } else {
+      entity.template Vector<T>().at(field_id_) = value;
+    }
+  }
+
+  ANALYSISTREE_ATTR_NODISCARD Integer_t GetFieldId() const { return field_id_; }
+  ANALYSISTREE_ATTR_NODISCARD bool IsInitialized() const { return is_init_; }
+
+  /**
+   * @brief Reads field field_id of type T, used by Field. Fields added by user are not bounds-checked,
+   * unless ANALYSISTREE_FIELD_CHECKS is defined
+   */
+  static T Read(const Entity& entity, Integer_t field_id) {
+    if (field_id < 0) {
+      return entity.template GetField<T>(field_id);
+    }
+#ifdef ANALYSISTREE_FIELD_CHECKS
+    return entity.template GetVector<T>().at(field_id);
+#else
+    return entity.template GetVector<T>()[field_id];
+#endif
+  }
+
+  static void Write(Entity& entity, Integer_t field_id, T value) {
+    entity.template SetField<T>(value, field_id);
+  }
+
+ private:
+  using Getter = T (*)(const Entity&);
+  using Setter = void (*)(Entity&, T);
+
+  static constexpr Integer_t kMaxDefaultFields = 16;///< not less than number of default fields of any type of objects
+
+  template<Integer_t id>
+  static void SetDefault(Entity& entity, T value) { entity.template SetField<T>(value, id); }
+  static T One(const Entity&) { return T(1); }
+  static void NotSettable(Entity&, T) { throw std::runtime_error("FieldHandle - field ones cannot be set"); }
+
+  template<std::size_t... i>
+  static Setter GetDefaultSetter(Integer_t field_id, std::index_sequence<i...>) {
+    static const Setter setters[] = {&FieldHandle::SetDefault<-static_cast<Integer_t>(i) - 1>...};
+    return setters[-field_id - 1];
+  }
+
+  void Check(const Entity& entity) const {
+    if (!is_init_) {
+      throw std::runtime_error("FieldHandle - handle is not initialized");
+    }
+    if (getter_ == nullptr && static_cast<size_t>(field_id_) >= entity.template GetVector<T>().size()) {
+      throw std::out_of_range("FieldHandle - field id " + std::to_string(field_id_) + " is out of range");
+    }
+  }
+
+  Getter getter_{nullptr};///< for default fields, nullptr otherwise
+  Setter setter_{nullptr};
+  Integer_t field_id_{UndefValueInt};
+  bool is_init_{false};
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_INFRA_FIELDHANDLE_HPP_
@@ -62,9 +62,12 @@ void GenericContainerFiller::Init() {
   generic_detector_ = new GenericDetector(branchConfig.GetId());
 
   file_out_ = TFile::Open(file_out_name_.c_str(), "recreate");
+  output_profile_.Apply(file_out_);
   tree_out_ = new TTree(tree_out_name_.c_str(), "Analysis Tree");
   tree_out_->SetAutoSave(0);
-  tree_out_->Branch((branchConfig.GetName() + ".").c_str(), "AnalysisTree::GenericDetector", &generic_detector_);
+  tree_out_->Branch((branchConfig.GetName() + ".").c_str(), "AnalysisTree::GenericDetector", &generic_detector_,
+                    output_profile_.GetBasketSize(), output_profile_.GetSplitLevel());
+  output_profile_.Apply(tree_out_);
 
   entry_switch_trigger_id_ = entry_switch_trigger_var_name_.empty() ? -999 : DetermineFieldIdByName(branch_map_, entry_switch_trigger_var_name_);
 }
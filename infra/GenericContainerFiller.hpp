@@ -8,6 +8,7 @@
 #include "Configuration.hpp"
 #include "Container.hpp"
 #include "Detector.hpp"
+#include "OutputProfile.hpp"
 
 #include <TChain.h>
 #include <TFile.h>
@@ -55,6 +56,9 @@ class GenericContainerFiller {
 
   void SetNChannelsPerEntry(int n) { n_channels_per_entry_ = n; }
 
+  void SetOutputProfile(eOutputProfile profile) { output_profile_ = OutputProfile::Get(profile); }
+  void SetOutputProfile(const OutputProfile& profile) { output_profile_ = profile; }
+
   void Run(int nEntries = -1);
 
  protected:
@@ -76,6 +80,7 @@ class GenericContainerFiller {
   TChain* tree_in_{nullptr};
   TFile* file_out_{nullptr};
   TTree* tree_out_{nullptr};
+  OutputProfile output_profile_{};
 
   AnalysisTree::Configuration config_;
   AnalysisTree::GenericDetector* generic_detector_{nullptr};
@@ -0,0 +1,114 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include "KinematicsColumns.hpp"
+
+#include <cmath>
+
+namespace AnalysisTree {
+
+/**
+ * @brief Momentum components are copied to contiguous arrays first, so that the loops over them are vectorizable
+ */
+template<class T>
+void KinematicsColumns::FillMomentum(const std::vector<T>& channels) {
+  const auto n = channels.size();
+  px_.resize(n);
+  py_.resize(n);
+  pz_.resize(n);
+  pt_.resize(n);
+  p_.resize(n);
+  phi_.resize(n);
+  eta_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    px_[i] = channels[i].GetPx();
+    py_[i] = channels[i].GetPy();
+    pz_[i] = channels[i].GetPz();
+  }
+  const auto* px = px_.data();
+  const auto* py = py_.data();
+  const auto* pz = pz_.data();
+  auto* pt = pt_.data();
+  auto* p = p_.data();
+  for (size_t i = 0; i < n; ++i) {
+    pt[i] = std::sqrt(px[i] * px[i] + py[i] * py[i]);
+    p[i] = std::sqrt(px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i]);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    phi_[i] = std::atan2(py[i], px[i]);
+    eta_[i] = 0.5f * std::log((p[i] + pz[i]) / (p[i] - pz[i]));
+  }
+}
+
+void KinematicsColumns::Fill(const TrackDetector& tracks) {
+  type_ = DetType::kTrack;
+  FillMomentum(*tracks.GetChannels());
+  mass_.clear();
+  energy_.clear();
+  rapidity_.clear();
+}
+
+void KinematicsColumns::Fill(const Particles& particles) {
+  type_ = DetType::kParticle;
+  const auto& channels = *particles.GetChannels();
+  FillMomentum(channels);
+  const auto n = channels.size();
+  mass_.resize(n);
+  energy_.resize(n);
+  rapidity_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    mass_[i] = channels[i].GetMass();
+  }
+  for (size_t i = 0; i < n; ++i) {
+    energy_[i] = std::sqrt(mass_[i] * mass_[i] + p_[i] * p_[i]);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    rapidity_[i] = 0.5f * std::log((energy_[i] + pz_[i]) / (energy_[i] - pz_[i]));
+  }
+}
+
+const std::vector<Floating_t>* KinematicsColumns::GetColumn(Integer_t field_id) const {
+  if (type_ == DetType::kTrack) {
+    switch (field_id) {
+      case TrackFields::kPt: return &pt_;
+      case TrackFields::kP: return &p_;
+      case TrackFields::kPhi: return &phi_;
+      case TrackFields::kEta: return &eta_;
+      default: return nullptr;
+    }
+  }
+  switch (field_id) {
+    case ParticleFields::kPt: return &pt_;
+    case ParticleFields::kP: return &p_;
+    case ParticleFields::kPhi: return &phi_;
+    case ParticleFields::kEta: return &eta_;
+    case ParticleFields::kEnergy: return &energy_;
+    case ParticleFields::kRapidity: return &rapidity_;
+    default: return nullptr;
+  }
+}
+
+template<class T>
+void KinematicsColumns::ReadColumn(const std::vector<Floating_t>& column, Integer_t field_id, const T* channels, size_t first, size_t n, double* out) const {
+  for (size_t i = 0; i < n; ++i) {
+    const auto i_channel = first + i;
+    const auto& channel = channels[i_channel];
+    out[i] = i_channel < column.size() && IsCurrent(i_channel, channel) ? column[i_channel] : channel.template GetField<float>(field_id);
+  }
+}
+
+bool KinematicsColumns::Read(Integer_t field_id, const Track* channels, size_t first, size_t n, double* out) const {
+  const auto* column = type_ == DetType::kTrack ? GetColumn(field_id) : nullptr;
+  if (column == nullptr) return false;
+  ReadColumn(*column, field_id, channels, first, n, out);
+  return true;
+}
+
+bool KinematicsColumns::Read(Integer_t field_id, const Particle* channels, size_t first, size_t n, double* out) const {
+  const auto* column = type_ == DetType::kParticle ? GetColumn(field_id) : nullptr;
+  if (column == nullptr) return false;
+  ReadColumn(*column, field_id, channels, first, n, out);
+  return true;
+}
+
+}// namespace AnalysisTree
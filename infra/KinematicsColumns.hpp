@@ -0,0 +1,83 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_KINEMATICSCOLUMNS_HPP_
+#define ANALYSISTREE_INFRA_KINEMATICSCOLUMNS_HPP_
+
+#include <vector>
+
+#include "Constants.hpp"
+#include "Detector.hpp"
+
+namespace AnalysisTree {
+
+/**
+ * @brief KinematicsColumns keeps pT, p, phi and eta (and energy and rapidity of particles) of all channels of one
+ * track or particle branch, computed for the current entry in one vectorizable pass. The values are kept next to
+ * the branch, not in the objects, so that Track and Particle and their getters are not changed.
+ * Columns are addressed with ids of default fields, e.g. Field::GetFieldId() or FieldHandle::GetFieldId().
+ * Momentum (and mass of particles) is kept as it was at Fill(), so that Read() notices channels changed after it
+ */
+class KinematicsColumns {
+
+ public:
+  KinematicsColumns() = default;
+  explicit KinematicsColumns(DetType type) : type_(type) {}
+
+  void Fill(const TrackDetector& tracks);
+  void Fill(const Particles& particles);
+
+  /**
+   * @return column of the default field field_id, nullptr if the field is not kept for this type of branch
+   */
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<Floating_t>* GetColumn(Integer_t field_id) const;
+
+  /**
+   * @brief Reads the default field field_id of channels [first, first + n) from its column. Channels added after
+   * Fill() or with momentum (or mass) changed since then are computed from the object instead
+   * @return false if the field is not kept for this type of channels, out is not touched then
+   */
+  bool Read(Integer_t field_id, const Track* channels, size_t first, size_t n, double* out) const;
+  bool Read(Integer_t field_id, const Particle* channels, size_t first, size_t n, double* out) const;
+  template<class T>
+  bool Read(Integer_t, const T*, size_t, size_t, double*) const { return false; }
+
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<Floating_t>& GetPt() const { return pt_; }
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<Floating_t>& GetP() const { return p_; }
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<Floating_t>& GetPhi() const { return phi_; }
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<Floating_t>& GetEta() const { return eta_; }
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<Floating_t>& GetEnergy() const { return energy_; }
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<Floating_t>& GetRapidity() const { return rapidity_; }
+
+  ANALYSISTREE_ATTR_NODISCARD DetType GetType() const { return type_; }
+  ANALYSISTREE_ATTR_NODISCARD size_t size() const { return pt_.size(); }
+
+ private:
+  template<class T>
+  void FillMomentum(const std::vector<T>& channels);
+  template<class T>
+  void ReadColumn(const std::vector<Floating_t>& column, Integer_t field_id, const T* channels, size_t first, size_t n, double* out) const;
+
+  bool IsCurrent(size_t i, const Track& track) const {
+    return px_[i] == track.GetPx() && py_[i] == track.GetPy() && pz_[i] == track.GetPz();
+  }
+  bool IsCurrent(size_t i, const Particle& particle) const {
+    return IsCurrent(i, static_cast<const Track&>(particle)) && mass_[i] == particle.GetMass();
+  }
+
+  DetType type_{DetType::kTrack};
+  std::vector<Floating_t> px_{};
+  std::vector<Floating_t> py_{};
+  std::vector<Floating_t> pz_{};
+  std::vector<Floating_t> pt_{};
+  std::vector<Floating_t> p_{};
+  std::vector<Floating_t> phi_{};
+  std::vector<Floating_t> eta_{};
+  std::vector<Floating_t> mass_{};    ///< particles only
+  std::vector<Floating_t> energy_{};  ///< particles only
+  std::vector<Floating_t> rapidity_{};///< particles only
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_INFRA_KINEMATICSCOLUMNS_HPP_
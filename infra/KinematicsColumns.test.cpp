@@ -0,0 +1,99 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_KINEMATICSCOLUMNS_TEST_CPP_
+#define ANALYSISTREE_INFRA_KINEMATICSCOLUMNS_TEST_CPP_
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+#include "Branch.hpp"
+#include "KinematicsColumns.hpp"
+
+namespace {
+
+using namespace AnalysisTree;
+
+TEST(KinematicsColumns, Fill) {
+  BranchConfig tracks_config("tracks", DetType::kTrack);
+  BranchConfig particles_config("particles", DetType::kParticle);
+  TrackDetector tracks(tracks_config.GetId());
+  Particles particles(particles_config.GetId());
+  for (int i = 0; i < 10; ++i) {
+    const float px = std::rand() * (1. / RAND_MAX * 2.) - 1.;
+    const float py = std::rand() * (1. / RAND_MAX * 1.5);
+    const float pz = 2. + std::rand() * (1. / RAND_MAX);
+    tracks.AddChannel(tracks_config).SetMomentum(px, py, pz);
+    auto& particle = particles.AddChannel(particles_config);
+    particle.SetMomentum(px, py, pz);
+    particle.SetPid(211);
+  }
+
+  KinematicsColumns track_columns;
+  KinematicsColumns particle_columns;
+  track_columns.Fill(tracks);
+  particle_columns.Fill(particles);
+
+  ASSERT_EQ(track_columns.size(), 10);
+  ASSERT_EQ(particle_columns.size(), 10);
+  for (size_t i = 0; i < tracks.GetNumberOfChannels(); ++i) {
+    const auto& track = tracks.GetChannel(i);
+    EXPECT_FLOAT_EQ(track_columns.GetPt()[i], track.GetPt());
+    EXPECT_FLOAT_EQ(track_columns.GetP()[i], track.GetP());
+    EXPECT_FLOAT_EQ(track_columns.GetPhi()[i], track.GetPhi());
+    EXPECT_FLOAT_EQ(track_columns.GetEta()[i], track.GetEta());
+
+    const auto& particle = particles.GetChannel(i);
+    EXPECT_FLOAT_EQ(particle_columns.GetEta()[i], particle.GetEta());
+    EXPECT_FLOAT_EQ(particle_columns.GetEnergy()[i], particle.GetEnergy());
+    EXPECT_FLOAT_EQ(particle_columns.GetRapidity()[i], particle.GetRapidity());
+  }
+
+  EXPECT_EQ(track_columns.GetColumn(TrackFields::kPt), &track_columns.GetPt());
+  EXPECT_EQ(track_columns.GetColumn(TrackFields::kPx), nullptr);
+  EXPECT_EQ(particle_columns.GetColumn(ParticleFields::kRapidity), &particle_columns.GetRapidity());
+  EXPECT_EQ(particle_columns.GetColumn(ParticleFields::kMass), nullptr);
+}
+
+TEST(KinematicsColumns, ReadAfterWrite) {
+  BranchConfig config("particles", DetType::kParticle);
+  Configuration configuration;
+  configuration.AddBranchConfig(config);
+  auto* particles = new Particles(config.GetId());
+  for (int i = 0; i < 4; ++i) {
+    auto& particle = particles->AddChannel(config);
+    particle.SetMomentum(0.1f * i, 0.5f, 1.f + i);
+    particle.SetPid(211);
+  }
+  KinematicsColumns columns;
+  columns.Fill(*particles);
+
+  Branch branch(config, particles);
+  branch.SetKinematics(&columns);
+  const auto pt = branch.GetField("pT");
+  const auto rapidity = branch.GetField("rapidity");
+
+  std::vector<double> values(4);
+  EXPECT_FALSE(columns.Read(ParticleFields::kPx, particles->GetChannels()->data(), 0, 4, values.data()));
+  EXPECT_FALSE(columns.Read(TrackFields::kPt, particles->GetChannels()->data(), 0, 4, values.data()));// particle is not read as a track
+
+  particles->Channel(1).SetMomentum(3.f, 4.f, 0.f);// column of channel 1 is stale now
+  particles->Channel(2).SetPid(2212);
+  particles->AddChannel(config).SetMomentum(6.f, 8.f, 0.f);// not in the columns
+
+  values.resize(5);
+  branch.GetFieldValues(pt, 0, 5, values.data());
+  EXPECT_FLOAT_EQ(values[0], columns.GetPt()[0]);
+  EXPECT_FLOAT_EQ(values[1], 5.f);
+  EXPECT_FLOAT_EQ(values[4], 10.f);
+  branch.GetFieldValues(rapidity, 0, 5, values.data());
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_FLOAT_EQ(values[i], particles->GetChannel(i).GetRapidity()) << i;
+    EXPECT_FLOAT_EQ(branch[i].Value(rapidity), particles->GetChannel(i).GetRapidity()) << i;
+  }
+}
+
+}// namespace
+
+#endif//ANALYSISTREE_INFRA_KINEMATICSCOLUMNS_TEST_CPP_
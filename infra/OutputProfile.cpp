@@ -0,0 +1,72 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include "OutputProfile.hpp"
+
+#include <Compression.h>
+#include <TBranch.h>
+#include <TFile.h>
+#include <TTree.h>
+
+#include <stdexcept>
+
+namespace AnalysisTree {
+
+OutputProfile OutputProfile::Get(eOutputProfile profile) {
+  using Algorithm = ROOT::RCompressionSetting::EAlgorithm;
+  OutputProfile result;
+  switch (profile) {
+    case eOutputProfile::kDefault: break;
+    case eOutputProfile::kFastWrite: {
+      result.compression = ROOT::CompressionSettings(Algorithm::kLZ4, 4);
+      break;
+    }
+    case eOutputProfile::kArchival: {
+      result.compression = ROOT::CompressionSettings(Algorithm::kLZMA, 8);
+      result.basket_size = 128000;
+      break;
+    }
+    case eOutputProfile::kAnalysis: {
+      result.compression = ROOT::CompressionSettings(Algorithm::kZSTD, 5);
+      result.basket_size = 256000;
+      result.auto_flush = -100000000;// 100 MB clusters
+      break;
+    }
+    default: throw std::runtime_error("OutputProfile::Get - unknown profile");
+  }
+  return result;
+}
+
+std::string OutputProfile::GetName(eOutputProfile profile) {
+  switch (profile) {
+    case eOutputProfile::kDefault: return "default";
+    case eOutputProfile::kFastWrite: return "fast-write";
+    case eOutputProfile::kArchival: return "archival";
+    case eOutputProfile::kAnalysis: return "analysis";
+    default: throw std::runtime_error("OutputProfile::GetName - unknown profile");
+  }
+}
+
+void OutputProfile::Apply(TFile* file) const {
+  if (file != nullptr && compression >= 0) {
+    file->SetCompressionSettings(compression);
+  }
+}
+
+void OutputProfile::Apply(TTree* tree) const {
+  if (tree == nullptr) return;
+  if (auto_flush != 0) {
+    tree->SetAutoFlush(auto_flush);
+  }
+  if (basket_size > 0) {
+    tree->SetBasketSize("*", basket_size);
+  }
+  if (compression >= 0) {
+    auto* branches = tree->GetListOfBranches();
+    for (int i = 0; i < branches->GetEntries(); ++i) {
+      static_cast<TBranch*>(branches->At(i))->SetCompressionSettings(compression);// sub-branches are set as well
+    }
+  }
+}
+
+}// namespace AnalysisTree
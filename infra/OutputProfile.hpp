@@ -0,0 +1,54 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_OUTPUTPROFILE_HPP_
+#define ANALYSISTREE_INFRA_OUTPUTPROFILE_HPP_
+
+#include <string>
+
+#include <RtypesCore.h>
+
+#include "Constants.hpp"
+
+class TFile;
+class TTree;
+
+namespace AnalysisTree {
+
+enum class eOutputProfile : short {
+  kDefault = 0,///< ROOT defaults
+  kFastWrite,  ///< LZ4, fast compression and decompression, larger files
+  kArchival,   ///< LZMA, smallest files, slow compression
+  kAnalysis    ///< ZSTD with large baskets and clusters, for repeated reading
+};
+
+/**
+ * @brief Output file and tree settings shared by all writers: TaskManager, PlainTreeFiller and GenericContainerFiller.
+ * Negative (or zero for auto-flush) values keep ROOT defaults.
+ */
+struct OutputProfile {
+  int compression{-1};  ///< algorithm * 100 + level, see ROOT::CompressionSettings()
+  Int_t basket_size{-1};///< buffer size of branches in bytes
+  Long64_t auto_flush{0};///< see TTree::SetAutoFlush(), negative value means size of cluster in bytes
+  Int_t split_level{-1};
+
+  static OutputProfile Get(eOutputProfile profile);
+  static std::string GetName(eOutputProfile profile);
+
+  ANALYSISTREE_ATTR_NODISCARD Int_t GetBasketSize() const { return basket_size > 0 ? basket_size : 32000; }
+  ANALYSISTREE_ATTR_NODISCARD Int_t GetSplitLevel() const { return split_level >= 0 ? split_level : 99; }
+
+  /**
+   * @brief Sets compression of the file, should be called before trees are created
+   */
+  void Apply(TFile* file) const;
+
+  /**
+   * @brief Sets auto-flush of the tree, and compression and basket size of already existing branches
+   */
+  void Apply(TTree* tree) const;
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_INFRA_OUTPUTPROFILE_HPP_
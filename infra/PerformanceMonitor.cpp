@@ -0,0 +1,206 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include "PerformanceMonitor.hpp"
+
+#include <TFile.h>
+#include <TNamed.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/resource.h>
+
+namespace AnalysisTree {
+
+void DurationHistogram::Fill(double seconds) {
+  auto bin = seconds > 0. ? static_cast<int>(std::floor((std::log10(seconds) - kMinExponent) * kBinsPerDecade)) : 0;
+  bin = std::max(0, std::min(bin, kNBins - 1));
+  bins_[bin]++;
+  entries_++;
+  sum_ += seconds;
+  max_ = std::max(max_, seconds);
+}
+
+void DurationHistogram::Merge(const DurationHistogram& other) {
+  for (size_t i = 0; i < bins_.size(); ++i) {
+    bins_[i] += other.bins_[i];
+  }
+  entries_ += other.entries_;
+  sum_ += other.sum_;
+  max_ = std::max(max_, other.max_);
+}
+
+void DurationHistogram::Clear() {
+  std::fill(bins_.begin(), bins_.end(), 0);
+  entries_ = 0;
+  sum_ = 0.;
+  max_ = 0.;
+}
+
+double DurationHistogram::GetQuantile(double q) const {
+  if (entries_ == 0) {
+    return 0.;
+  }
+  const auto rank = static_cast<unsigned long long>(std::ceil(q * static_cast<double>(entries_)));
+  unsigned long long sum{0};
+  for (size_t i = 0; i < bins_.size(); ++i) {
+    sum += bins_[i];
+    if (sum >= std::max(rank, 1ull)) {
+      return std::min(max_, std::pow(10., kMinExponent + (static_cast<double>(i) + 0.5) / kBinsPerDecade));
+    }
+  }
+  return max_;
+}
+
+void PerformanceMonitor::Start(const std::vector<std::string>& task_names) {
+  tasks_.clear();
+  for (const auto& name : task_names) {
+    tasks_.push_back({name});
+  }
+  read_.wall.Clear();
+  fill_.wall.Clear();
+  n_events_ = 0;
+  start_ = Clock::now();
+  bytes_read_at_start_ = TFile::GetFileBytesRead();
+  is_running_ = true;
+}
+
+void PerformanceMonitor::Stop() {
+  if (!is_running_) {
+    return;
+  }
+  stop_ = Clock::now();
+  bytes_read_at_stop_ = TFile::GetFileBytesRead();
+  is_running_ = false;
+}
+
+void PerformanceMonitor::Merge(const PerformanceMonitor& other) {
+  if (other.tasks_.size() != tasks_.size()) {
+    throw std::runtime_error("PerformanceMonitor::Merge - different number of tasks");
+  }
+  for (size_t i = 0; i < tasks_.size(); ++i) {
+    tasks_[i].wall.Merge(other.tasks_[i].wall);
+    tasks_[i].cpu.Merge(other.tasks_[i].cpu);
+  }
+  read_.wall.Merge(other.read_.wall);
+  fill_.wall.Merge(other.fill_.wall);
+  n_events_ += other.n_events_;
+}
+
+void PerformanceMonitor::AddTaskExec(size_t i_task, double wall, double cpu) {
+  tasks_[i_task].wall.Fill(wall);
+  tasks_[i_task].cpu.Fill(cpu);
+}
+
+double PerformanceMonitor::GetElapsed() const {
+  return GetSeconds(start_, is_running_ ? Clock::now() : stop_);
+}
+
+double PerformanceMonitor::GetMBytesRead() const {
+  const auto bytes_read = is_running_ ? TFile::GetFileBytesRead() : bytes_read_at_stop_;
+  return static_cast<double>(bytes_read - bytes_read_at_start_) / 1024. / 1024.;
+}
+
+double PerformanceMonitor::GetThreadCpuTime() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<double>(ts.tv_sec) + 1e-9 * static_cast<double>(ts.tv_nsec);
+#else
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+double PerformanceMonitor::GetPeakRSS() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return static_cast<double>(usage.ru_maxrss) / 1024. / 1024.;// bytes
+#else
+  return static_cast<double>(usage.ru_maxrss) / 1024.;// kilobytes
+#endif
+}
+
+void PerformanceMonitor::Print(bool is_full, std::ostream& out) const {
+  const auto elapsed = GetElapsed();
+  const auto mbytes = GetMBytesRead();
+  out << "Performance: " << n_events_ << " events in " << elapsed << " s, "
+      << (elapsed > 0. ? n_events_ / elapsed : 0.) << " events/s, "
+      << (elapsed > 0. ? mbytes / elapsed : 0.) << " MB/s read, "
+      << "peak RSS " << GetPeakRSS() << " MB\n";
+  if (!is_full) {
+    return;
+  }
+
+  auto print_item = [&out](const Item& item) {
+    const auto& w = item.wall;
+    out << std::left << std::setw(30) << item.name << std::right
+        << std::setw(10) << w.GetEntries()
+        << std::setw(12) << w.GetSum()
+        << std::setw(12) << w.GetQuantile(0.5) * 1e6
+        << std::setw(12) << w.GetQuantile(0.9) * 1e6
+        << std::setw(12) << w.GetQuantile(0.99) * 1e6
+        << std::setw(12) << w.GetMax() * 1e6
+        << std::setw(12) << item.cpu.GetSum() << "\n";
+  };
+  out << std::left << std::setw(30) << "name" << std::right
+      << std::setw(10) << "calls"
+      << std::setw(12) << "wall, s"
+      << std::setw(12) << "p50, us"
+      << std::setw(12) << "p90, us"
+      << std::setw(12) << "p99, us"
+      << std::setw(12) << "max, us"
+      << std::setw(12) << "cpu, s" << "\n";
+  for (const auto& task : tasks_) {
+    print_item(task);
+  }
+  print_item(read_);
+  print_item(fill_);
+}
+
+void PerformanceMonitor::Write() const {
+  std::string name;
+  unsigned long long calls;
+  double wall, cpu, p50, p90, p99, max;
+
+  auto* tree = new TTree("PerformanceSummary", "Timing of TaskManager event loop");
+  tree->Branch("name", &name);
+  tree->Branch("calls", &calls);
+  tree->Branch("wall", &wall);
+  tree->Branch("cpu", &cpu);
+  tree->Branch("p50", &p50);
+  tree->Branch("p90", &p90);
+  tree->Branch("p99", &p99);
+  tree->Branch("max", &max);
+
+  auto fill = [&](const Item& item) {
+    name = item.name;
+    calls = item.wall.GetEntries();
+    wall = item.wall.GetSum();
+    cpu = item.cpu.GetSum();
+    p50 = item.wall.GetQuantile(0.5);
+    p90 = item.wall.GetQuantile(0.9);
+    p99 = item.wall.GetQuantile(0.99);
+    max = item.wall.GetMax();
+    tree->Fill();
+  };
+  for (const auto& task : tasks_) {
+    fill(task);
+  }
+  fill(read_);
+  fill(fill_);
+  tree->Write();
+  delete tree;
+
+  std::stringstream summary;
+  Print(true, summary);
+  TNamed("PerformanceSummary_text", summary.str()).Write();
+}
+
+}// namespace AnalysisTree
@@ -0,0 +1,124 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_PERFORMANCEMONITOR_HPP_
+#define ANALYSISTREE_INFRA_PERFORMANCEMONITOR_HPP_
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Constants.hpp"
+
+namespace AnalysisTree {
+
+/**
+ * @brief Histogram of durations with logarithmic bins (from 1 ns to 1000 s, 20 bins per decade).
+ * Quantiles are estimated with the precision of the bin width (about 12%)
+ */
+class DurationHistogram {
+
+ public:
+  void Fill(double seconds);
+  void Merge(const DurationHistogram& other);
+  void Clear();
+
+  /**
+   * @param q quantile, from 0 to 1
+   * @return geometric center of the bin containing the quantile, 0 if histogram is empty
+   */
+  ANALYSISTREE_ATTR_NODISCARD double GetQuantile(double q) const;
+  ANALYSISTREE_ATTR_NODISCARD double GetSum() const { return sum_; }
+  ANALYSISTREE_ATTR_NODISCARD double GetMax() const { return max_; }
+  ANALYSISTREE_ATTR_NODISCARD unsigned long long GetEntries() const { return entries_; }
+
+ private:
+  static constexpr int kBinsPerDecade{20};
+  static constexpr int kMinExponent{-9};
+  static constexpr int kNBins{12 * kBinsPerDecade};
+
+  std::vector<unsigned long long> bins_ = std::vector<unsigned long long>(kNBins, 0);
+  unsigned long long entries_{0};
+  double sum_{0.};
+  double max_{0.};
+};
+
+/**
+ * @brief Collects timing of the event loop of TaskManager: wall and CPU time of Exec() of every task,
+ * wall time of reading of entries and of filling of the output tree, read throughput and peak memory use.
+ * In parallel event loop every thread has its own PerformanceMonitor, they are merged in the end
+ */
+class PerformanceMonitor {
+
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Item {
+    std::string name{};
+    DurationHistogram wall{};
+    DurationHistogram cpu{};
+  };
+
+  /**
+   * @brief Resets all counters and starts the clock
+   * @param task_names names of the tasks, in order of execution
+   */
+  void Start(const std::vector<std::string>& task_names);
+  /**
+   * @brief Stops the clock, elapsed time and read throughput do not change after it
+   */
+  void Stop();
+  void Merge(const PerformanceMonitor& other);
+
+  void AddTaskExec(size_t i_task, double wall, double cpu);
+  void AddRead(double wall) { read_.wall.Fill(wall); }
+  void AddFill(double wall) { fill_.wall.Fill(wall); }
+  void AddEvent() { n_events_++; }
+
+  /**
+   * @brief Prints a short line with throughput (is_full = false) or a table with all timings
+   */
+  void Print(bool is_full = true, std::ostream& out = std::cout) const;
+
+  /**
+   * @brief Writes TTree "PerformanceSummary" and TNamed "PerformanceSummary_text" with printout into the current ROOT directory
+   */
+  void Write() const;
+
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<Item>& GetTasks() const { return tasks_; }
+  ANALYSISTREE_ATTR_NODISCARD const Item& GetRead() const { return read_; }
+  ANALYSISTREE_ATTR_NODISCARD const Item& GetFill() const { return fill_; }
+  ANALYSISTREE_ATTR_NODISCARD unsigned long long GetNEvents() const { return n_events_; }
+  ANALYSISTREE_ATTR_NODISCARD double GetElapsed() const;
+  ANALYSISTREE_ATTR_NODISCARD double GetMBytesRead() const;
+
+  /**
+   * @return CPU time used by the calling thread, in seconds
+   */
+  static double GetThreadCpuTime();
+
+  /**
+   * @return peak resident set size of the process, in MB
+   */
+  static double GetPeakRSS();
+
+  static double GetSeconds(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double>(end - start).count();
+  }
+
+ private:
+  std::vector<Item> tasks_{};
+  Item read_{"GetEntry"};
+  Item fill_{"Fill"};
+  unsigned long long n_events_{0};
+  Clock::time_point start_{};
+  Clock::time_point stop_{};
+  long long bytes_read_at_start_{0};
+  long long bytes_read_at_stop_{0};
+  bool is_running_{false};
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_INFRA_PERFORMANCEMONITOR_HPP_
@@ -0,0 +1,74 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_PERFORMANCEMONITOR_TEST_CPP_
+#define ANALYSISTREE_INFRA_PERFORMANCEMONITOR_TEST_CPP_
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include <infra/PerformanceMonitor.hpp>
+
+namespace {
+
+using namespace AnalysisTree;
+
+TEST(PerformanceMonitor, Quantiles) {
+  DurationHistogram hist;
+  EXPECT_EQ(hist.GetQuantile(0.5), 0.);
+
+  for (int i = 1; i <= 1000; ++i) {
+    hist.Fill(i * 1e-6);
+  }
+  EXPECT_EQ(hist.GetEntries(), 1000);
+  EXPECT_NEAR(hist.GetSum(), 0.5005, 1e-9);
+  EXPECT_DOUBLE_EQ(hist.GetMax(), 1e-3);
+  EXPECT_NEAR(hist.GetQuantile(0.5), 500e-6, 0.15 * 500e-6);
+  EXPECT_NEAR(hist.GetQuantile(0.9), 900e-6, 0.15 * 900e-6);
+  EXPECT_LE(hist.GetQuantile(1.), hist.GetMax());
+
+  DurationHistogram other;
+  other.Fill(10.);
+  hist.Merge(other);
+  EXPECT_EQ(hist.GetEntries(), 1001);
+  EXPECT_DOUBLE_EQ(hist.GetMax(), 10.);
+  EXPECT_NEAR(hist.GetQuantile(1.), 10., 1.5);
+}
+
+TEST(PerformanceMonitor, Merge) {
+  PerformanceMonitor monitor;
+  PerformanceMonitor worker;
+  monitor.Start({"0:Task"});
+  worker.Start({"0:Task"});
+
+  for (int i = 0; i < 10; ++i) {
+    monitor.AddRead(1e-4);
+    monitor.AddTaskExec(0, 1e-3, 1e-3);
+    monitor.AddEvent();
+    worker.AddRead(1e-4);
+    worker.AddTaskExec(0, 2e-3, 1e-3);
+    worker.AddEvent();
+  }
+  monitor.Merge(worker);
+  monitor.Stop();
+
+  EXPECT_EQ(monitor.GetNEvents(), 20);
+  EXPECT_EQ(monitor.GetRead().wall.GetEntries(), 20);
+  EXPECT_EQ(monitor.GetTasks().at(0).wall.GetEntries(), 20);
+  EXPECT_NEAR(monitor.GetTasks().at(0).wall.GetSum(), 0.03, 1e-9);
+  EXPECT_EQ(monitor.GetElapsed(), monitor.GetElapsed());
+  EXPECT_GT(PerformanceMonitor::GetPeakRSS(), 0.);
+
+  std::stringstream out;
+  monitor.Print(true, out);
+  EXPECT_NE(out.str().find("0:Task"), std::string::npos);
+
+  PerformanceMonitor wrong;
+  wrong.Start({});
+  EXPECT_THROW(monitor.Merge(wrong), std::runtime_error);
+}
+
+}// namespace
+
+#endif//ANALYSISTREE_INFRA_PERFORMANCEMONITOR_TEST_CPP_
@@ -79,7 +79,11 @@ void PlainTreeFiller::Init() {
 
   if (vars_.size() != vars.size()) throw std::runtime_error("PlainTreeFiller::Init(): vars_.size() != vars.size()");
 
+  if (!is_own_output_profile_) {
+    output_profile_ = TaskManager::GetInstance()->GetOutputProfile();
+  }
   file_ = TFile::Open(file_name_.c_str(), "recreate");
+  output_profile_.Apply(file_);
   plain_tree_ = new TTree(tree_name_.c_str(), "Plain Tree");
   plain_tree_->SetAutoSave(0);
   for (size_t i = 0; i < vars.size(); ++i) {
@@ -94,6 +98,7 @@ void PlainTreeFiller::Init() {
     else if (vars_.at(i).type_ == Types::kBool)
       plain_tree_->Branch(leaf_name.c_str(), &vars_.at(i).bool_, Form("%s/O", leaf_name.c_str()));
   }
+  output_profile_.Apply(plain_tree_);
 
   for (auto& cm : cuts_map_) {
     if (cm.second != nullptr) {
@@ -8,6 +8,7 @@
 
 #include "AnalysisTask.hpp"
 #include "Detector.hpp"
+#include "OutputProfile.hpp"
 #include "Variable.hpp"
 
 namespace AnalysisTree {
@@ -34,6 +35,15 @@ class PlainTreeFiller : public AnalysisTask {
     tree_name_ = std::move(tree);
   }
 
+  /**
+   * @brief Sets compression, basket size and auto-flush of the output. By default the profile of TaskManager is used
+   */
+  void SetOutputProfile(eOutputProfile profile) { SetOutputProfile(OutputProfile::Get(profile)); }
+  void SetOutputProfile(const OutputProfile& profile) {
+    output_profile_ = profile;
+    is_own_output_profile_ = true;
+  }
+
   void SetFieldsToIgnore(const std::vector<std::string>& fields_to_ignore);
   void SetFieldsToPreserve(const std::vector<std::string>& fields_to_preserve);
 
@@ -52,6 +62,9 @@ class PlainTreeFiller : public AnalysisTask {
   std::vector<std::string> fields_to_ignore_{};
   std::vector<std::string> fields_to_preserve_{};
 
+  OutputProfile output_profile_{};
+  bool is_own_output_profile_{false};
+
   bool is_ignore_defual_fields_{false};
   bool is_prepend_leaves_with_branchname_{true};
 };
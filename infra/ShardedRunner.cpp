@@ -0,0 +1,285 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#include "ShardedRunner.hpp"
+
+#include "BranchConfig.hpp"
+#include "BranchHashHelper.hpp"
+#include "Configuration.hpp"
+#include "DataHeader.hpp"
+#include "TaskManager.hpp"
+
+#include <TFile.h>
+#include <TFileMerger.h>
+#include <TNamed.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace AnalysisTree {
+
+namespace {
+/**
+ * Commit info written by TaskManager, copied from the first file
+ */
+const std::vector<std::string> kCommitInfo{"AnalysisTree_tag", "AnalysisTree_commit_hash", "AnalysisTree_commit_is_original"};
+/**
+ * Objects which are not merged by TFileMerger
+ */
+const std::vector<std::string> kNotMerged{"Configuration", "DataHeader", "PerformanceSummary_text",
+                                          "AnalysisTree_tag", "AnalysisTree_commit_hash", "AnalysisTree_commit_is_original"};
+}// namespace
+
+void ShardedRunner::Run(const std::vector<std::string>& filelists, const std::vector<std::string>& in_trees, long long nEvents) {
+  auto* man = TaskManager::GetInstance();
+  if (!man->IsFillOutTree()) {
+    throw std::runtime_error("ShardedRunner::Run - output file is not set, use TaskManager::SetOutputName()");
+  }
+  if (filelists.empty() || filelists.size() != in_trees.size()) {
+    throw std::runtime_error("ShardedRunner::Run - filelists and tree names do not match");
+  }
+  if (mode_ == eShardMode::kFiles && nEvents >= 0) {
+    throw std::runtime_error("ShardedRunner::Run - number of events can be limited only in eShardMode::kEntries");
+  }
+
+  const auto output = man->GetOutputFileName();
+  auto n_shards = std::max(n_processes_, 1);
+  if (mode_ == eShardMode::kFiles) {
+    if (man->GetIsReadRegisteredFriends() && !Chain::GetRegisteredFriends(filelists.at(0)).empty()) {
+      std::cout << "Warning: ShardedRunner::Run - friends registered for " << filelists.at(0) << " are not carried over to "
+                << "the filelists of shards in eShardMode::kFiles, add them to filelists explicitly or use eShardMode::kEntries" << std::endl;
+    }
+    n_shards = std::min(n_shards, static_cast<int>(ReadLines(filelists.at(0)).size()));
+    if (n_shards == 0) {
+      throw std::runtime_error("ShardedRunner::Run - filelist " + filelists.at(0) + " is empty");
+    }
+  }
+
+  const auto stem = output.size() > 5 && output.substr(output.size() - 5) == ".root" ? output.substr(0, output.size() - 5) : output;
+  shard_files_.clear();
+  for (int i_shard = 0; i_shard < n_shards; ++i_shard) {
+    shard_files_.emplace_back(stem + "_shard" + std::to_string(i_shard) + ".root");
+  }
+  const auto shard_lists = mode_ == eShardMode::kFiles ? SplitFileLists(filelists) : std::vector<std::vector<std::string>>(n_shards, filelists);
+
+  std::cout << "ShardedRunner::Run - " << n_shards << " processes\n";
+  std::cout.flush();
+  std::fflush(stdout);
+
+  std::vector<pid_t> pids{};
+  for (int i_shard = 0; i_shard < n_shards; ++i_shard) {
+    const auto pid = fork();
+    if (pid < 0) {
+      throw std::runtime_error("ShardedRunner::Run - fork() failed");
+    }
+    if (pid == 0) {// child process
+      int status{0};
+      try {
+        RunShard(i_shard, shard_lists.at(i_shard), in_trees, nEvents);
+      } catch (const std::exception& e) {
+        std::cerr << "ShardedRunner::Run - shard " << i_shard << " failed: " << e.what() << std::endl;
+        status = 1;
+      }
+      std::cout.flush();
+      std::fflush(stdout);
+      _exit(status);
+    }
+    pids.emplace_back(pid);
+  }
+
+  int n_failed{0};
+  for (const auto pid : pids) {
+    int status{0};
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      n_failed++;
+    }
+  }
+  if (n_failed > 0) {
+    throw std::runtime_error("ShardedRunner::Run - " + std::to_string(n_failed) + " of " + std::to_string(n_shards) + " processes failed");
+  }
+
+  Merge(shard_files_, output);
+  std::cout << "ShardedRunner::Run - output is merged into " << output << std::endl;
+
+  if (!is_keep_shards_) {
+    for (const auto& file : shard_files_) {
+      std::remove(file.c_str());
+    }
+  }
+  for (const auto& filelist : shard_filelists_) {
+    std::remove(filelist.c_str());
+  }
+  shard_filelists_.clear();
+}
+
+void ShardedRunner::RunShard(int i_shard, const std::vector<std::string>& filelists, const std::vector<std::string>& in_trees, long long nEvents) const {
+  auto* man = TaskManager::GetInstance();
+  man->SetOutputName(shard_files_.at(i_shard), man->GetOutputTreeName());
+  man->Init(filelists, in_trees);
+
+  if (mode_ == eShardMode::kEntries) {
+    const auto n_entries = man->GetChain()->GetEntries();
+    const auto n = nEvents < 0 || nEvents > n_entries ? n_entries : nEvents;
+    const auto n_shards = static_cast<long long>(shard_files_.size());
+    const auto first = n * i_shard / n_shards;
+    const auto last = n * (i_shard + 1) / n_shards;
+    man->SetFirstEntry(first);
+    man->Run(last - first);
+  } else {
+    man->Run(-1);
+  }
+  man->Finish();
+}
+
+std::vector<std::string> ShardedRunner::ReadLines(const std::string& filelist) {
+  std::ifstream in(filelist);
+  if (!in.is_open()) {
+    throw std::runtime_error("ShardedRunner::ReadLines - cannot open " + filelist);
+  }
+  std::vector<std::string> lines{};
+  std::string line;
+  while (in >> line) {
+    lines.emplace_back(line);
+  }
+  return lines;
+}
+
+std::vector<std::vector<std::string>> ShardedRunner::SplitFileLists(const std::vector<std::string>& filelists) {
+  const auto n_shards = shard_files_.size();
+  std::vector<std::vector<std::string>> result(n_shards);
+
+  std::vector<std::vector<std::string>> lines{};
+  for (const auto& filelist : filelists) {
+    lines.emplace_back(ReadLines(filelist));
+    if (lines.back().size() != lines.front().size()) {
+      throw std::runtime_error("ShardedRunner::SplitFileLists - filelists " + filelists.front() + " and " + filelist + " have different number of files");
+    }
+  }
+
+  const auto n_files = lines.front().size();
+  for (size_t i_shard = 0; i_shard < n_shards; ++i_shard) {
+    for (size_t i_list = 0; i_list < filelists.size(); ++i_list) {
+      const auto name = shard_files_.at(i_shard) + ".filelist" + std::to_string(i_list) + ".txt";
+      std::ofstream out(name);
+      for (auto i_file = n_files * i_shard / n_shards; i_file < n_files * (i_shard + 1) / n_shards; ++i_file) {
+        out << lines.at(i_list).at(i_file) << "\n";
+      }
+      shard_filelists_.emplace_back(name);
+      result.at(i_shard).emplace_back(name);
+    }
+  }
+  return result;
+}
+
+void ShardedRunner::Merge(const std::vector<std::string>& inputs, const std::string& output) {
+  if (inputs.empty()) {
+    throw std::runtime_error("ShardedRunner::Merge - no input files");
+  }
+
+  std::unique_ptr<Configuration> config{nullptr};
+  std::unique_ptr<DataHeader> data_header{nullptr};
+  std::vector<std::unique_ptr<TNamed>> commit_info{};
+
+  for (const auto& input : inputs) {
+    std::unique_ptr<TFile> file{TFile::Open(input.c_str(), "read")};
+    if (!file || file->IsZombie()) {
+      throw std::runtime_error("ShardedRunner::Merge - cannot open " + input);
+    }
+    std::unique_ptr<Configuration> config_i{(Configuration*) file->Get("Configuration")};
+    std::unique_ptr<DataHeader> data_header_i{(DataHeader*) file->Get("DataHeader")};
+    if (!config_i) {
+      throw std::runtime_error("ShardedRunner::Merge - no Configuration in " + input);
+    }
+
+    if (!config) {
+      config = std::move(config_i);
+      data_header = std::move(data_header_i);
+      for (const auto& name : kCommitInfo) {
+        auto* named = (TNamed*) file->Get(name.c_str());
+        if (named != nullptr) {
+          commit_info.emplace_back(named);
+        }
+      }
+      continue;
+    }
+    CheckConsistency(*config, *config_i, input);
+    if ((data_header == nullptr) != (data_header_i == nullptr)) {
+      throw std::runtime_error("ShardedRunner::Merge - DataHeader is missing in some files, e.g. " + input);
+    }
+    if (data_header) {
+      CheckConsistency(*data_header, *data_header_i, input);
+    }
+  }
+
+  TFileMerger merger(false, false);
+  merger.SetPrintLevel(0);
+  if (!merger.OutputFile(output.c_str(), "RECREATE")) {
+    throw std::runtime_error("ShardedRunner::Merge - cannot create " + output);
+  }
+  for (const auto& input : inputs) {
+    merger.AddFile(input.c_str(), false);
+  }
+  for (const auto& name : kNotMerged) {
+    merger.AddObjectNames(name.c_str());
+  }
+  if (!merger.PartialMerge(TFileMerger::kAll | TFileMerger::kRegular | TFileMerger::kSkipListed)) {
+    throw std::runtime_error("ShardedRunner::Merge - merging into " + output + " failed");
+  }
+
+  std::unique_ptr<TFile> out{TFile::Open(output.c_str(), "update")};
+  if (!out || out->IsZombie()) {
+    throw std::runtime_error("ShardedRunner::Merge - cannot open " + output);
+  }
+  out->cd();
+  config->Write("Configuration");
+  if (data_header) {
+    data_header->Write("DataHeader");
+  }
+  for (const auto& named : commit_info) {
+    named->Write();
+  }
+  out->Close();
+}
+
+void ShardedRunner::CheckConsistency(const Configuration& ref, const Configuration& other, const std::string& file) {
+  const auto& ref_branches = ref.GetBranchConfigs();
+  const auto& other_branches = other.GetBranchConfigs();
+  if (ref_branches.size() != other_branches.size()) {
+    throw std::runtime_error("ShardedRunner::CheckConsistency - different number of branches in " + file);
+  }
+  for (const auto& branch : ref_branches) {
+    auto it = other_branches.find(branch.first);
+    if (it == other_branches.end() || it->second.GetName() != branch.second.GetName()
+        || Impl::BranchConfigHasher(it->second) != Impl::BranchConfigHasher(branch.second)) {
+      throw std::runtime_error("ShardedRunner::CheckConsistency - branch " + branch.second.GetName() + " is different in " + file);
+    }
+  }
+
+  const auto& ref_matches = ref.GetMatchingConfigs();
+  const auto& other_matches = other.GetMatchingConfigs();
+  if (ref_matches.size() != other_matches.size()) {
+    throw std::runtime_error("ShardedRunner::CheckConsistency - different number of matchings in " + file);
+  }
+  for (size_t i = 0; i < ref_matches.size(); ++i) {
+    if (ref_matches[i].GetFirstBranchName() != other_matches[i].GetFirstBranchName()
+        || ref_matches[i].GetSecondBranchName() != other_matches[i].GetSecondBranchName()
+        || ref_matches[i].GetDataBranchName() != other_matches[i].GetDataBranchName()) {
+      throw std::runtime_error("ShardedRunner::CheckConsistency - matching " + ref_matches[i].GetDataBranchName() + " is different in " + file);
+    }
+  }
+}
+
+void ShardedRunner::CheckConsistency(const DataHeader& ref, const DataHeader& other, const std::string& file) {
+  if (ref.GetSystem() != other.GetSystem() || ref.GetBeamRapidity() != other.GetBeamRapidity()) {
+    throw std::runtime_error("ShardedRunner::CheckConsistency - DataHeader is different in " + file);
+  }
+}
+
+}// namespace AnalysisTree
@@ -0,0 +1,81 @@
+/* Copyright (C) 2019-2021 GSI, Universität Tübingen
+   SPDX-License-Identifier: GPL-3.0-only
+   Authors: Viktor Klochkov, Ilya Selyuzhenkov */
+#ifndef ANALYSISTREE_INFRA_SHARDEDRUNNER_HPP_
+#define ANALYSISTREE_INFRA_SHARDEDRUNNER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "Constants.hpp"
+
+namespace AnalysisTree {
+
+class Configuration;
+class DataHeader;
+
+enum class eShardMode : short {
+  kFiles = 0,///< every process reads its own part of the files from the filelists, registered friends (Chain::RegisterFriend()) are not read
+  kEntries   ///< every process reads all files, but its own range of entries
+};
+
+/**
+ * @brief ShardedRunner runs the analysis configured in TaskManager in several local processes and merges their outputs.
+ * Tasks and output are set up in TaskManager as usual (AddTask(), SetOutputName(), etc.), then
+ * ShardedRunner::Run() is called instead of TaskManager::Init(), Run() and Finish(). Every process is forked
+ * with the same set of tasks, runs TaskManager on its shard of the input and writes its own output file.
+ * Output files are merged with TFileMerger into the output file of TaskManager, after consistency checks
+ * of Configuration and DataHeader. Tasks are not finished in the calling process, all results
+ * should be written to the output file to be merged.
+ */
+class ShardedRunner {
+
+ public:
+  explicit ShardedRunner(int n_processes, eShardMode mode = eShardMode::kFiles) : n_processes_(n_processes),
+                                                                                   mode_(mode) {}
+
+  /**
+   * @brief Runs analysis in forked processes and merges outputs
+   * @param filelists vector of filelists, as in TaskManager::Init()
+   * @param in_trees vector of TTree names
+   * @param nEvents number of events to process in total, only in eShardMode::kEntries; -1 means all
+   */
+  void Run(const std::vector<std::string>& filelists, const std::vector<std::string>& in_trees, long long nEvents = -1);
+
+  /**
+   * @brief Merges AnalysisTree files. Trees and other mergeable objects are merged with TFileMerger,
+   * Configuration, DataHeader and AnalysisTree commit info are taken from the first file.
+   * Throws if branches (names, ids, field hashes) or matchings in Configuration, or DataHeaders differ between files
+   * @param inputs names of input files
+   * @param output name of output file
+   */
+  static void Merge(const std::vector<std::string>& inputs, const std::string& output);
+
+  static void CheckConsistency(const Configuration& ref, const Configuration& other, const std::string& file);
+  static void CheckConsistency(const DataHeader& ref, const DataHeader& other, const std::string& file);
+
+  void SetIsKeepShards(bool is = true) { is_keep_shards_ = is; }
+
+  ANALYSISTREE_ATTR_NODISCARD int GetNProcesses() const { return n_processes_; }
+  ANALYSISTREE_ATTR_NODISCARD const std::vector<std::string>& GetShardFileNames() const { return shard_files_; }
+
+ protected:
+  /**
+   * @brief Writes filelists for every shard, with its part of lines of the input filelists
+   * @return filelists of shards
+   */
+  std::vector<std::vector<std::string>> SplitFileLists(const std::vector<std::string>& filelists);
+  static std::vector<std::string> ReadLines(const std::string& filelist);
+
+  void RunShard(int i_shard, const std::vector<std::string>& filelists, const std::vector<std::string>& in_trees, long long nEvents) const;
+
+  int n_processes_{1};
+  eShardMode mode_{eShardMode::kFiles};
+  bool is_keep_shards_{false};
+  std::vector<std::string> shard_files_{};
+  std::vector<std::string> shard_filelists_{};///< temporary filelists written in eShardMode::kFiles
+};
+
+}// namespace AnalysisTree
+
+#endif//ANALYSISTREE_INFRA_SHARDEDRUNNER_HPP_
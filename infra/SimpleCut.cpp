@@ -3,6 +3,7 @@
    Authors: Viktor Klochkov, Ilya Selyuzhenkov */
 #include "SimpleCut.hpp"
 
+#include "Branch.hpp"
 #include "HelperFunctions.hpp"
 
 #include <iostream>
@@ -45,6 +46,10 @@ SimpleCut EqualsCut(const Variable& var, int value, const std::string& title) {
   return SimpleCut(var, value, title);
 }
 
+SimpleCut ExpressionCut(const std::string& formula, const std::string& title) {
+  return SimpleCut(Expression(formula), title);
+}
+
 SimpleCut OpenCut(const std::string& branchName, const std::string& title) {
   return SimpleCut({branchName + ".ones"}, [](const std::vector<double>& par) { return true; });
 }
@@ -52,15 +57,32 @@ SimpleCut OpenCut(const std::string& branchName, const std::string& title) {
 SimpleCut::SimpleCut(const Variable& var, int value, std::string title) : title_(std::move(title)) {
   vars_.emplace_back(var);
   lambda_ = [value](std::vector<double>& vars) { return vars[0] <= value + SmallNumber && vars[0] >= value - SmallNumber; };
+  type_ = eCutType::kRange;
+  lo_ = value - SmallNumber;
+  hi_ = value + SmallNumber;
   FillBranchNames();
   const std::string stringForHash = var.GetName() + HelperFunctions::ToStringWithPrecision(value, 6) + title_;
   std::hash<std::string> hasher;
   hash_ = hasher(stringForHash);
 }
 
+SimpleCut::SimpleCut(const Expression& expression, std::string title) : title_(std::move(title)),
+                                                                     expression_(expression) {
+  for (const auto& field_name : expression.GetFieldNames()) {
+    vars_.emplace_back(Variable::FromString(field_name));
+  }
+  lambda_ = [expression](std::vector<double>& vars) { return expression.Evaluate(vars) != 0.; };
+  FillBranchNames();
+  std::hash<std::string> hasher;
+  hash_ = hasher(expression.GetCanonical() + title_);
+}
+
 SimpleCut::SimpleCut(const Variable& var, double min, double max, std::string title) : title_(std::move(title)) {
   vars_.emplace_back(var);
   lambda_ = [max, min](std::vector<double>& vars) { return vars[0] <= max && vars[0] >= min; };
+  type_ = eCutType::kRange;
+  lo_ = min;
+  hi_ = max;
   FillBranchNames();
   const std::string stringForHash = var.GetName() + HelperFunctions::ToStringWithPrecision(min, 6) + HelperFunctions::ToStringWithPrecision(max, 6) + title_;
   std::hash<std::string> hasher;
@@ -90,13 +112,81 @@ bool SimpleCut::Apply(const BranchChannel& a, size_t a_id, const BranchChannel&
   return result;
 }
 
+void SimpleCut::Bind(const std::vector<size_t>& branch_ids) {
+  for (auto& var : vars_) {
+    var.Bind(branch_ids);
+  }
+}
+
+bool SimpleCut::ApplyBound(const std::vector<const BranchChannel*>& bch, std::vector<double>& values) const {
+  values.clear();
+  for (const auto& var : vars_) {
+    values.emplace_back(var.GetBoundValue(bch));
+  }
+  return lambda_(values);
+}
+
+void SimpleCut::ApplyBatch(const Branch& branch, std::vector<char>& mask) const {
+  std::vector<double> column;
+  std::vector<double> values;
+  ApplyBatch(branch, mask, column, values);
+}
+
+void SimpleCut::ApplyBatch(const Branch& branch, std::vector<char>& mask, std::vector<double>& column, std::vector<double>& values) const {
+  const auto n_channels = mask.size();
+  const auto n_vars = vars_.size();
+  for (const auto& var : vars_) {
+    if (var.GetNumberOfBranches() != 1 || var.GetFields().at(0).GetBranchId() != branch.GetConfig().GetId()) {
+      throw std::runtime_error("SimpleCut::ApplyBatch - variable " + var.GetName() + " is not defined on branch " + branch.GetBranchName());
+    }
+  }
+  column.resize(n_vars * n_channels);
+  for (size_t i_var = 0; i_var < n_vars; ++i_var) {
+    vars_[i_var].GetValues(branch, 0, n_channels, column.data() + i_var * n_channels);
+  }
+
+  if (type_ == eCutType::kRange) {
+    const double* data = column.data();
+    char* result = mask.data();
+    const auto lo = lo_;
+    const auto hi = hi_;
+    for (size_t i = 0; i < n_channels; ++i) {// no branches, vectorized by the compiler
+      result[i] &= static_cast<char>((data[i] >= lo) & (data[i] <= hi));
+    }
+    return;
+  }
+
+  if (!expression_.IsEmpty()) {
+    values.resize(n_channels);
+    expression_.EvaluateBatch(column.data(), n_channels, values.data());
+    for (size_t i = 0; i < n_channels; ++i) {
+      mask[i] &= static_cast<char>(values[i] != 0.);
+    }
+    return;
+  }
+
+  values.resize(n_vars);
+  for (size_t i_channel = 0; i_channel < n_channels; ++i_channel) {
+    if (!mask[i_channel]) continue;
+    for (size_t i_var = 0; i_var < n_vars; ++i_var) {
+      values[i_var] = column[i_var * n_channels + i_channel];
+    }
+    mask[i_channel] = lambda_(values);
+  }
+}
+
 bool SimpleCut::Apply(const BranchChannel& object) const {
-  std::vector<double> variables;
-  variables.reserve(vars_.size());
+  std::vector<double> values;
+  values.reserve(vars_.size());
+  return Apply(object, values);
+}
+
+bool SimpleCut::Apply(const BranchChannel& object, std::vector<double>& values) const {
+  values.clear();
   for (const auto& var : vars_) {
-    variables.emplace_back(var.GetValue(object));
+    values.emplace_back(var.GetValue(object));
   }
-  return lambda_(variables);
+  return lambda_(values);
 }
 }// namespace AnalysisTree
 
@@ -83,6 +83,14 @@ class SimpleCut {
   */
   friend SimpleCut EqualsCut(const Variable& var, int value, const std::string& title);
 
+  /**
+  * Constructor for cut defined by a formula of fields, see Expression for the syntax.
+  * Channels with non-zero value of the formula are accepted.
+  * Cuts defined by the same formula and title are equal
+  * @param formula e.g. "sqrt(VtxTracks.px^2+VtxTracks.py^2) > 0.2 && VtxTracks.nhits >= 4"
+  */
+  friend SimpleCut ExpressionCut(const std::string& formula, const std::string& title);
+
   /**
   * Constructor for a cut which is always passed
   * (needed for keeping generality of the user's code, when a set of cuts
@@ -110,6 +118,29 @@ class SimpleCut {
   bool Apply(std::vector<const BranchChannel*>& bch, std::vector<size_t>& id) const;
   [[deprecated]] bool Apply(const BranchChannel& a, size_t a_id, const BranchChannel& b, size_t b_id) const;
 
+  /**
+   * @brief Evaluates cut with a buffer of the caller for values of variables, so that repeated calls do not allocate
+   * @param values scratch buffer, its content is overwritten
+   */
+  bool Apply(const BranchChannel& object, std::vector<double>& values) const;
+
+  /**
+   * @brief Binds Variables to the branch positions, see Variable::Bind()
+   */
+  void Bind(const std::vector<size_t>& branch_ids);
+  bool ApplyBound(const std::vector<const BranchChannel*>& bch, std::vector<double>& values) const;
+
+  /**
+   * @brief Evaluates cut for all channels of the branch at once. Variables must be defined on this branch only.
+   * RangeCut and EqualsCut are evaluated with a branch-free loop over the column of values,
+   * other cuts call the lambda for each channel
+   * @param mask one byte per channel (not a packed bitmask, so that the compare loop is vectorized by the compiler):
+   * mask[i] is set to 0 for channels i failing the cut, others are kept. Channels already masked are not evaluated by the lambda
+   * @param column, values scratch buffers of the caller, their content is overwritten
+   */
+  void ApplyBatch(const Branch& branch, std::vector<char>& mask, std::vector<double>& column, std::vector<double>& values) const;
+  void ApplyBatch(const Branch& branch, std::vector<char>& mask) const;
+
   void Print() const;
 
   void SetTitle(const std::string& title) { title_ = title; }
@@ -124,14 +155,27 @@ class SimpleCut {
  protected:
   SimpleCut(const Variable& var, double min, double max, std::string title = "");
   SimpleCut(const Variable& var, int value, std::string title = "");
+  SimpleCut(const Expression& expression, std::string title = "");
 
   void FillBranchNames();
 
+  /**
+   * Kind of the cut, known for RangeCut and EqualsCut, so that they can be evaluated without the lambda
+   */
+  enum class eCutType : short {
+    kLambda = 0,
+    kRange
+  };
+
   std::string title_;
   std::vector<Variable> vars_{};
   std::set<std::string> branch_names_{};
   std::function<bool(std::vector<double>&)> lambda_;///< function used to evaluate the cut.
   size_t hash_;
+  eCutType type_{eCutType::kLambda};//!
+  double lo_{0.};                   //! accepted range for eCutType::kRange
+  double hi_{0.};                   //!
+  Expression expression_{};         //! formula of ExpressionCut, evaluated by ApplyBatch() without the lambda
 
   ClassDef(SimpleCut, 1);
 };
@@ -139,6 +183,7 @@ SimpleCut RangeCut(const std::string& variable_name, double lo, double hi, const
 SimpleCut EqualsCut(const std::string& variable_name, int value, const std::string& title = "");
 SimpleCut RangeCut(const Variable& var, double lo, double hi, const std::string& title = "");
 SimpleCut EqualsCut(const Variable& var, int value, const std::string& title = "");
+SimpleCut ExpressionCut(const std::string& formula, const std::string& title = "");
 SimpleCut OpenCut(const std::string& branchName, const std::string& title = "alwaysTrue");
 
 }// namespace AnalysisTree
@@ -9,12 +9,18 @@ namespace AnalysisTree {
 
 ANALYSISTREE_ATTR_NODISCARD bool Task::IsGoodEvent(const Chain& t) const {
   if (!event_cuts_) return true;
-  auto br_name = event_cuts_->GetBranches().begin();
-  const auto branch = t.GetBranchObject(*br_name);
-  if (branch.GetBranchType() != DetType::kEventHeader) {
+  if (&t == event_header_chain_) {// resolved in PreInit()
+    return event_cuts_->Apply(*event_header_);
+  }
+  return event_cuts_->Apply(*GetEventHeader(t));
+}
+
+const EventHeader* Task::GetEventHeader(const Chain& t) const {
+  const auto& br_name = *event_cuts_->GetBranches().begin();
+  if (t.GetConfiguration()->GetBranchConfig(br_name).GetType() != DetType::kEventHeader) {
     throw std::runtime_error("EventHeader is expected");
   }
-  return event_cuts_->Apply(branch[0]);
+  return ANALYSISTREE_UTILS_GET<EventHeader*>(t.GetPointerToBranch(br_name));
 }
 
 void Task::PreInit() {
@@ -22,9 +28,27 @@ void Task::PreInit() {
   config_ = man->GetConfig();
   data_header_ = man->GetDataHeader();
 
+  event_header_chain_ = nullptr;
+  event_header_ = nullptr;
   if (event_cuts_) {
     event_cuts_->Init(*config_);
+    const auto* chain = man->GetChain();
+    event_header_ = GetEventHeader(*chain);
+    event_header_chain_ = chain;
+  }
+}
+
+void Task::CopyCuts() {
+  event_cuts_ = GetCutsCopy(event_cuts_);
+}
+
+Cuts* Task::GetCutsCopy(const Cuts* cuts) {
+  if (cuts == nullptr) return nullptr;
+  auto& copy = cuts_copies_[cuts];
+  if (!copy) {
+    copy = std::make_shared<Cuts>(*cuts);
   }
+  return copy.get();
 }
 
 }// namespace AnalysisTree
\ No newline at end of file
@@ -4,6 +4,8 @@
 #ifndef ANALYSISTREE_INFRA_TASK_HPP_
 #define ANALYSISTREE_INFRA_TASK_HPP_
 
+#include <map>
+#include <memory>
 #include <set>
 
 #include "Configuration.hpp"
@@ -34,6 +36,25 @@ class Task {
 
   void PreInit();
 
+  /**
+   * @brief Creates a copy of the task for a worker thread of the parallel event loop, see TaskManager::SetNThreads().
+   * Called before Init(). If a task does not override it, serial event loop is used.
+   * @return pointer to the new task of the same type or nullptr
+   */
+  ANALYSISTREE_ATTR_NODISCARD virtual Task* Clone() const { return nullptr; }
+
+  /**
+   * @brief Merges results of a worker copy created with Clone() into this task. Called before Finish().
+   * @param other worker copy of this task
+   */
+  virtual void Merge(const Task& /* other */) {}
+
+  /**
+   * @brief Replaces non-owned Cuts by private copies, so that a worker copy does not share
+   * mutable state (e.g. Variable buffers) with the original task
+   */
+  virtual void CopyCuts();
+
   void SetInConfiguration(const Configuration* config) { config_ = config; }
   void SetDataHeader(const DataHeader* data_header) { data_header_ = data_header; }
 
@@ -54,15 +75,49 @@ class Task {
     event_cuts_ = cuts;
   }
 
+  ANALYSISTREE_ATTR_NODISCARD const Cuts* GetEventCuts() const { return event_cuts_; }
+
   void AddInputBranch(const std::string& name) { in_branches_.emplace(name); }
 
+  /**
+   * @brief Sets the pass of the event loop in which Exec() of the task is called, 0 by default.
+   * TaskManager::Run() loops over the input once per pass, in increasing order, so that tasks of later passes can use
+   * results of earlier ones (e.g. calibration constants), see FinishPass()
+   */
+  void SetPass(int pass) {
+    if (pass < 0) {
+      throw std::runtime_error("Task::SetPass - pass should not be negative");
+    }
+    pass_ = pass;
+  }
+  ANALYSISTREE_ATTR_NODISCARD int GetPass() const { return pass_; }
+
+  /**
+   * @brief Called after the event loop of the pass of the task, before the next pass starts.
+   * Results needed by tasks of later passes should be finalized here, Finish() is called only in TaskManager::Finish()
+   */
+  virtual void FinishPass() {}
+
  protected:
+  /**
+   * @brief Returns private copy of the cuts, the same copy is returned for the same cuts
+   */
+  Cuts* GetCutsCopy(const Cuts* cuts);
+  /**
+   * @brief Returns EventHeader of the chain used in event cuts
+   */
+  const EventHeader* GetEventHeader(const Chain& t) const;
+
   const Configuration* config_{nullptr};
   const DataHeader* data_header_{nullptr};
 
   Cuts* event_cuts_{nullptr};
+  const EventHeader* event_header_{nullptr};//! used by event cuts, resolved in PreInit()
+  const Chain* event_header_chain_{nullptr};//! chain of event_header_
 
   std::set<std::string> in_branches_{};
+  std::map<const Cuts*, std::shared_ptr<Cuts>> cuts_copies_{};//!
+  int pass_{0};
   bool is_init_{false};
 
   ClassDef(Task, 0);
@@ -3,10 +3,43 @@
    Authors: Viktor Klochkov, Ilya Selyuzhenkov */
 #include "TaskManager.hpp"
 
+#include "VariantMagic.hpp"
+
+#include <TBranch.h>
+#include <TClassEdit.h>
+#include <TROOT.h>
+#include <TSystem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <typeinfo>
 
 namespace AnalysisTree {
 
+namespace {
+/**
+ * Chain of the worker thread in parallel event loop, nullptr for the main Chain
+ */
+thread_local Chain* worker_chain = nullptr;
+
+/**
+ * Sets Chain returned by TaskManager::GetChain() in the current thread while in scope
+ */
+struct WorkerChainGuard {
+  explicit WorkerChainGuard(Chain* chain) { worker_chain = chain; }
+  ~WorkerChainGuard() { worker_chain = nullptr; }
+  WorkerChainGuard(const WorkerChainGuard&) = delete;
+  WorkerChainGuard& operator=(const WorkerChainGuard&) = delete;
+};
+}// namespace
+
 TaskManager* TaskManager::manager_ = nullptr;
 
 TaskManager* TaskManager::GetInstance() {
@@ -23,9 +56,13 @@ TaskManager* TaskManager::GetInstance() {
 void TaskManager::Init(const std::vector<std::string>& filelists, const std::vector<std::string>& in_trees) {
   assert(!is_init_);
   std::cout << "TaskManager::Init()\n";
-  is_init_ = true;
   read_in_tree_ = true;
-  chain_ = new Chain(filelists, in_trees);
+  ValidateRunConfiguration();
+  is_init_ = true;
+  if (fill_out_tree_ && write_mode_ == eBranchWriteMode::kFriendTree) {// output of the previous run is replaced
+    Chain::UnregisterFriend(filelists.at(0), GetFriendFileListName());
+  }
+  chain_ = new Chain(filelists, in_trees, is_read_registered_friends_);
 
   std::set<std::string> branch_names{};
   for (auto* task : tasks_) {
@@ -40,7 +77,29 @@ void TaskManager::Init(const std::vector<std::string>& filelists, const std::vec
 
   PrintCommitInfo();
 
+  if (n_threads_ > 1) {
+    InitWorkers(branch_names);
+  }
+
   InitTasks();
+  if (writer_ != nullptr) {// all output branches are added in Task::Init()
+    writer_->Start();
+  }
+  is_cache_init_ = InitCache(chain_);// matchings requested in Task::Init() are added
+
+  if (workers_.empty() && prefetch_depth_ > 0) {
+    // after Task::Init(), so that the matchings requested by tasks are known
+    for (const auto& match : chain_->GetMatchPointers()) {
+      branch_names.insert(match.first);
+    }
+    InitPrefetcher(branch_names);
+  }
+
+  InitEventCutBranches();
+  InitEventStore();
+  if (is_monitor_performance_) {
+    StartMonitors();
+  }
 }
 
 void TaskManager::InitTasks() {
@@ -48,30 +107,203 @@ void TaskManager::InitTasks() {
     task->PreInit();
     task->Init();
   }
+  for (auto& worker : workers_) {
+    WorkerChainGuard guard(worker.chain);
+    for (auto* task : worker.tasks) {
+      task->PreInit();
+      task->Init();
+    }
+  }
+}
+
+void TaskManager::ValidateRunConfiguration() const {
+  const bool is_copy_tree = fill_out_tree_ && (write_mode_ == eBranchWriteMode::kCopyTree || write_mode_ == eBranchWriteMode::kFastCopyTree);
+  if (n_threads_ > 1 && fill_out_tree_) {
+    throw std::runtime_error("TaskManager::ValidateRunConfiguration - parallel event loop is not supported if output tree is filled");
+  }
+  if (n_threads_ > 1 && GetPasses().size() > 1) {
+    throw std::runtime_error("TaskManager::ValidateRunConfiguration - several passes are not supported in parallel event loop");
+  }
+  if (prefetch_depth_ > 0 && fill_out_tree_ && write_mode_ == eBranchWriteMode::kCopyTree) {
+    throw std::runtime_error("TaskManager::ValidateRunConfiguration - prefetching is not supported in eBranchWriteMode::kCopyTree");
+  }
+  if (is_use_event_store_ && (n_threads_ > 1 || prefetch_depth_ > 0)) {
+    throw std::runtime_error("TaskManager::ValidateRunConfiguration - event store is not supported with parallel event loop and prefetching");
+  }
+  if (is_use_event_store_ && is_copy_tree) {
+    throw std::runtime_error("TaskManager::ValidateRunConfiguration - event store is not supported in eBranchWriteMode::kCopyTree and kFastCopyTree");
+  }
+  if (async_write_depth_ > 0 && is_copy_tree) {
+    throw std::runtime_error("TaskManager::ValidateRunConfiguration - asynchronous writing is supported only in eBranchWriteMode::kCreateNewTree and kFriendTree");
+  }
+  if (fill_out_tree_ && write_mode_ == eBranchWriteMode::kFriendTree && !read_in_tree_) {
+    throw std::runtime_error("TaskManager::ValidateRunConfiguration - eBranchWriteMode::kFriendTree needs input");
+  }
+}
+
+void TaskManager::InitWorkers(const std::set<std::string>& branch_names) {
+  ROOT::EnableThreadSafety();
+
+  for (int i_worker = 1; i_worker < n_threads_; ++i_worker) {
+    Worker worker;
+    for (auto* task : tasks_) {
+      auto* copy = task->Clone();
+      if (copy == nullptr) {// same for every worker, so no worker is created yet
+        for (auto* worker_task : worker.tasks) {
+          delete worker_task;
+        }
+        std::cout << "TaskManager::InitWorkers - task " << typeid(*task).name() << " does not implement Task::Clone(), serial event loop is used\n";
+        n_threads_ = 1;
+        return;
+      }
+      if (typeid(*copy) != typeid(*task)) {
+        delete copy;
+        throw std::runtime_error("TaskManager::InitWorkers - task " + std::string(typeid(*task).name()) + " does not implement Task::Clone()");
+      }
+      copy->CopyCuts();
+      worker.tasks.emplace_back(copy);
+    }
+    worker.chain = new Chain(chain_->GetFileLists(), chain_->GetTreeNames());
+    worker.chain->InitPointersToBranches(branch_names);
+    InitCache(worker.chain);
+    workers_.emplace_back(std::move(worker));
+  }
+  std::cout << "TaskManager::InitWorkers - " << n_threads_ << " threads\n";
+}
+
+void TaskManager::InitPrefetcher(const std::set<std::string>& branch_names) {
+  ROOT::EnableThreadSafety();
+
+  auto* reader = new Chain(chain_->GetFileLists(), chain_->GetTreeNames());
+  reader->InitPointersToBranches(branch_names);
+  InitCache(reader);
+  auto depth = prefetch_depth_;
+  if (prefetch_memory_limit_ > 0) {// the reader is moved, not the Chain of the event loop
+    depth = std::min(depth, EntryPrefetcher::GetDepthForMemory(*reader, prefetch_memory_limit_));
+  }
+  std::cout << "TaskManager::InitPrefetcher - " << depth << " entries\n";
+  prefetcher_ = new EntryPrefetcher(reader, depth);
+}
+
+void TaskManager::InitEventCutBranches() {
+  event_cut_branches_.clear();
+  if (!is_read_event_cuts_first_ || fill_out_tree_ || prefetcher_ != nullptr || tasks_.empty()) {
+    return;
+  }
+  std::set<std::string> names{};
+  for (auto* task : tasks_) {
+    const auto* cuts = task->GetEventCuts();
+    if (cuts == nullptr) {// every event is read for this task anyway
+      return;
+    }
+    names.insert(cuts->GetBranches().begin(), cuts->GetBranches().end());
+  }
+  event_cut_branches_.assign(names.begin(), names.end());
+  std::cout << "TaskManager::InitEventCutBranches - event cuts are checked before reading other branches\n";
+}
+
+bool TaskManager::InitCache(Chain* chain) const {
+  if (cache_size_ <= 0 || (fill_out_tree_ && write_mode_ == eBranchWriteMode::kCopyTree)) {
+    return false;
+  }
+  chain->InitCache(cache_size_);
+  return true;
+}
+
+void TaskManager::InitEventStore() {
+  if (!is_use_event_store_) return;
+  event_store_ = new EventStore(event_store_memory_limit_);
+}
+
+bool TaskManager::ReadEntry(Chain* chain, const std::vector<Task*>& tasks, long long entry, PerformanceMonitor* monitor,
+                            std::vector<char>& verdicts) const {
+  const auto start = PerformanceMonitor::Clock::now();
+  bool is_good{true};
+  verdicts.clear();
+  if (!event_cut_branches_.empty()) {
+    chain->GetEntryOfBranches(entry, event_cut_branches_);
+    verdicts.resize(tasks.size(), false);
+    is_good = false;
+    for (size_t i_task = 0; i_task < tasks.size(); ++i_task) {
+      const auto* task = tasks[i_task];
+      verdicts[i_task] = (current_pass_ < 0 || task->GetPass() == current_pass_) && task->IsGoodEvent(*chain);
+      is_good = is_good || verdicts[i_task];
+    }
+  }
+  if (is_good) {
+    chain->GetEntry(entry);
+  }
+  if (monitor != nullptr) {
+    monitor->AddRead(PerformanceMonitor::GetSeconds(start, PerformanceMonitor::Clock::now()));
+  }
+  return is_good;
+}
+
+void TaskManager::ExecTasks(const Chain& chain, const std::vector<Task*>& tasks, int pass, PerformanceMonitor* monitor,
+                            const std::vector<char>& verdicts) {
+  for (size_t i_task = 0; i_task < tasks.size(); ++i_task) {
+    auto* task = tasks[i_task];
+    if (pass >= 0 && task->GetPass() != pass) continue;
+    if (verdicts.empty() ? !task->IsGoodEvent(chain) : !verdicts[i_task]) continue;
+    if (monitor == nullptr) {
+      task->Exec();
+      continue;
+    }
+    const auto cpu_start = PerformanceMonitor::GetThreadCpuTime();
+    const auto start = PerformanceMonitor::Clock::now();
+    task->Exec();
+    monitor->AddTaskExec(i_task, PerformanceMonitor::GetSeconds(start, PerformanceMonitor::Clock::now()),
+                         PerformanceMonitor::GetThreadCpuTime() - cpu_start);
+  }
+}
+
+void TaskManager::StartMonitors() {
+  std::vector<std::string> names{};
+  for (size_t i_task = 0; i_task < tasks_.size(); ++i_task) {
+    const auto& type = typeid(*tasks_[i_task]);
+    int error{0};
+    char* demangled = TClassEdit::DemangleTypeIdName(type, error);
+    names.emplace_back(std::to_string(i_task) + ":" + (error == 0 && demangled != nullptr ? demangled : type.name()));
+    std::free(demangled);
+  }
+  monitor_.Start(names);
+  for (auto& worker : workers_) {
+    worker.monitor.Start(names);
+  }
 }
 
 void TaskManager::Init() {
   assert(!is_init_);
   std::cout << "TaskManager::Init()\n";
-  is_init_ = true;
   fill_out_tree_ = true;
+  ValidateRunConfiguration();
+  is_init_ = true;
 
   InitOutChain();
   chain_ = new Chain(out_tree_, configuration_, data_header_);
 
   InitTasks();
+  if (writer_ != nullptr) {// all output branches are added in Task::Init()
+    writer_->Start();
+  }
+  if (is_monitor_performance_) {// if Exec() is called directly, without Run()
+    StartMonitors();
+  }
 }
 
 void TaskManager::InitOutChain() {
   assert(fill_out_tree_);
   out_file_ = TFile::Open(out_file_name_.c_str(), "recreate");
+  output_profile_.Apply(out_file_);
   configuration_ = new Configuration("Configuration");
   data_header_ = new DataHeader;
 
-  if (write_mode_ == eBranchWriteMode::kCreateNewTree) {
+  if (write_mode_ == eBranchWriteMode::kCreateNewTree || write_mode_ == eBranchWriteMode::kFriendTree) {
     out_tree_ = new TTree(out_tree_name_.c_str(), "AnalysisTree");
-  } else if (write_mode_ == eBranchWriteMode::kCopyTree) {
+  } else if (write_mode_ == eBranchWriteMode::kCopyTree || write_mode_ == eBranchWriteMode::kFastCopyTree) {
+    const bool is_fast = write_mode_ == eBranchWriteMode::kFastCopyTree;
     assert(configuration_ && data_header_ && chain_);// input should exist
+    chain_->SetBranchStatus("*", true);              // all branches are copied, not only the ones used by tasks
     configuration_ = chain_->CloneConfiguration();
     *(data_header_) = *(chain_->GetDataHeader());
     for (auto& brex : branches_exclude_) {
@@ -84,21 +316,51 @@ void TaskManager::InitOutChain() {
       }
       configuration_->RemoveBranchConfig(brex);
     }
-    out_tree_ = chain_->CloneChain(0);
+    if (is_fast) {// written from the input objects, not copied
+      for (auto& name : branches_modified_) {
+        if (chain_->CheckBranchExistence(name) != 2) {
+          throw std::runtime_error("AnalysisTree::TaskManager::InitOutChain - modified branch " + name + " is not found in the input");
+        }
+        modified_branches_.emplace(name, chain_->GetPointerToBranch(name));
+        chain_->SetBranchStatus((name + ".*").c_str(), false);
+      }
+    }
+    out_tree_ = chain_->CloneChain(is_fast ? -1 : 0, is_fast ? "fast" : "");
     out_tree_->SetName(out_tree_name_.c_str());
     data_header_ = chain_->GetDataHeader();
-    chain_->SetBranchStatus("*", true);
+    if (is_fast) {
+      chain_->DisableNotLoadedBranches();// other branches are already copied
+      for (auto& branch : modified_branches_) {
+        create_branch_struct create(out_tree_, branch.first + ".", output_profile_.GetBasketSize(), output_profile_.GetSplitLevel());
+        fast_copy_fill_branches_.emplace_back(ANALYSISTREE_UTILS_VISIT(create, branch.second));
+      }
+    } else {
+      chain_->SetBranchStatus("*", true);
+    }
   }
+  output_profile_.Apply(out_tree_);// cloned branches in kCopyTree mode keep settings of the input otherwise, copied baskets in kFastCopyTree always do
   out_tree_->SetAutoSave(0);
+
+  if (async_write_depth_ > 0) {
+    ROOT::EnableThreadSafety();
+    writer_ = new AsyncTreeWriter(out_tree_, async_write_depth_);
+  }
 }
 
 void TaskManager::Run(long long nEvents) {
 
   std::cout << "AnalysisTree::Manager::Run" << std::endl;
-  auto start = std::chrono::system_clock::now();
 
   if (chain_->GetEntries() > 0) {
-    nEvents = nEvents < 0 || nEvents > chain_->GetEntries() ? chain_->GetEntries() : nEvents;
+    const auto n_available = std::max(chain_->GetEntries() - first_entry_, 0ll);
+    nEvents = nEvents < 0 || nEvents > n_available ? n_available : nEvents;
+  }
+
+  if (fill_out_tree_ && write_mode_ == eBranchWriteMode::kFastCopyTree && (first_entry_ != 0 || nEvents != out_tree_->GetEntries())) {
+    throw std::runtime_error("TaskManager::Run - all entries of the input should be processed in eBranchWriteMode::kFastCopyTree");
+  }
+  if (fill_out_tree_ && write_mode_ == eBranchWriteMode::kFriendTree && (first_entry_ != 0 || nEvents != chain_->GetEntries())) {
+    throw std::runtime_error("TaskManager::Run - all entries of the input should be processed in eBranchWriteMode::kFriendTree");
   }
 
   if (verbosity_frequency_ > 0) {
@@ -107,21 +369,202 @@ void TaskManager::Run(long long nEvents) {
     verbosity_period_ = static_cast<int>(std::pow(10, vPlog));
   }
 
-  for (long long iEvent = 0; iEvent < nEvents; ++iEvent) {
-    if (verbosity_period_ > 0 && iEvent % verbosity_period_ == 0) {
-      std::cout << "Event no " << iEvent << "\n";
+  const auto passes = GetPasses();
+  if (is_monitor_performance_) {// summary of all passes
+    StartMonitors();
+  }
+  last_pass_ = passes.back();
+  for (auto pass : passes) {
+    current_pass_ = pass;
+    if (passes.size() > 1) {
+      std::cout << "TaskManager::Run - pass " << pass << "\n";
+    }
+    RunPass(nEvents);
+    for (auto* task : tasks_) {
+      if (task->GetPass() == pass) task->FinishPass();
     }
-    if (read_in_tree_) {
-      chain_->GetEntry(iEvent);
+    for (auto& worker : workers_) {
+      for (auto* task : worker.tasks) {
+        if (task->GetPass() == pass) task->FinishPass();
+      }
     }
-    Exec();
-  }// Event loop
+  }
+  current_pass_ = -1;
+  if (is_cache_init_) {
+    chain_->PrintCacheStats();
+  }
+  if (is_monitor_performance_) {
+    monitor_.Stop();
+    monitor_.Print();
+  }
+}
+
+std::vector<int> TaskManager::GetPasses() const {
+  if (tasks_.empty()) {// event loop is still run, e.g. to fill the output
+    return {0};
+  }
+  std::set<int> passes{};
+  for (const auto* task : tasks_) {
+    passes.insert(task->GetPass());
+  }
+  return {passes.begin(), passes.end()};
+}
+
+void TaskManager::RunPass(long long nEvents) {
+  auto start = std::chrono::system_clock::now();
+  auto* monitor = is_monitor_performance_ ? &monitor_ : nullptr;
+
+  if (!workers_.empty()) {
+    RunParallel(nEvents);
+  } else {
+    if (prefetcher_ != nullptr) {
+      prefetcher_->Start(first_entry_, first_entry_ + nEvents);
+    }
+    for (long long iEvent = first_entry_; iEvent < first_entry_ + nEvents; ++iEvent) {
+      current_entry_ = iEvent;
+      if (verbosity_period_ > 0 && iEvent % verbosity_period_ == 0) {
+        std::cout << "Event no " << iEvent << "\n";
+        if (monitor != nullptr) {
+          monitor->Print(false);
+        }
+      }
+      bool is_good{true};
+      event_cuts_verdicts_.clear();
+      if (prefetcher_ != nullptr) {
+        const auto read_start = PerformanceMonitor::Clock::now();
+        prefetcher_->Next(*chain_);
+        if (monitor != nullptr) {
+          monitor->AddRead(PerformanceMonitor::GetSeconds(read_start, PerformanceMonitor::Clock::now()));
+        }
+      } else if (event_store_ != nullptr && event_store_->Contains(iEvent)) {
+        const auto read_start = PerformanceMonitor::Clock::now();
+        event_store_->Load(iEvent, *chain_);
+        if (monitor != nullptr) {
+          monitor->AddRead(PerformanceMonitor::GetSeconds(read_start, PerformanceMonitor::Clock::now()));
+        }
+      } else if (read_in_tree_) {
+        is_good = ReadEntry(chain_, tasks_, iEvent, monitor, event_cuts_verdicts_);
+        if (is_good && event_store_ != nullptr) {// event is read completely
+          event_store_->Add(iEvent, *chain_);
+        }
+      }
+      if (monitor != nullptr) {
+        monitor->AddEvent();
+      }
+      if (is_good) {
+        if (read_in_tree_ && is_cache_kinematics_) {
+          chain_->CacheKinematics();
+        }
+        Exec();
+      }
+    }// Event loop
+    if (prefetcher_ != nullptr) {
+      prefetcher_->Stop();
+    }
+  }
 
   auto end = std::chrono::system_clock::now();
   std::chrono::duration<double> elapsed_seconds = end - start;
   std::cout << "elapsed time: " << elapsed_seconds.count() << ", per event: " << elapsed_seconds.count() / nEvents << "s\n";
 }
 
+void TaskManager::RunParallel(long long nEvents) {
+  const auto n_workers = static_cast<long long>(workers_.size()) + 1;
+  std::atomic<long long> n_processed{0};
+  std::mutex print_mutex;
+  std::vector<std::exception_ptr> errors(n_workers);
+
+  auto process = [&](long long i_worker) {
+    try {
+      auto* chain = i_worker == 0 ? chain_ : workers_.at(i_worker - 1).chain;
+      const auto& tasks = i_worker == 0 ? tasks_ : workers_.at(i_worker - 1).tasks;
+      auto* monitor = !is_monitor_performance_ ? nullptr : i_worker == 0 ? &monitor_ : &workers_.at(i_worker - 1).monitor;
+      WorkerChainGuard guard(chain);
+
+      const long long first = first_entry_ + nEvents * i_worker / n_workers;
+      const long long last = first_entry_ + nEvents * (i_worker + 1) / n_workers;
+      std::vector<char> verdicts{};
+      for (long long iEvent = first; iEvent < last; ++iEvent) {
+        bool is_good{true};
+        if (read_in_tree_) {
+          is_good = ReadEntry(chain, tasks, iEvent, monitor, verdicts);
+          if (is_good && is_cache_kinematics_) {
+            chain->CacheKinematics();
+          }
+        }
+        if (is_good) {
+          ExecTasks(*chain, tasks, current_pass_, monitor, verdicts);
+        }
+        if (monitor != nullptr) {
+          monitor->AddEvent();
+        }
+        const auto n = ++n_processed;
+        if (verbosity_period_ > 0 && n % verbosity_period_ == 0) {
+          std::lock_guard<std::mutex> lock(print_mutex);
+          std::cout << "Events processed " << n << "\n";
+        }
+      }
+    } catch (...) {
+      errors.at(i_worker) = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(workers_.size());
+  for (long long i_worker = 1; i_worker < n_workers; ++i_worker) {
+    threads.emplace_back(process, i_worker);
+  }
+  process(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+  if (is_monitor_performance_) {
+    for (auto& worker : workers_) {
+      monitor_.Merge(worker.monitor);
+    }
+  }
+}
+
+void TaskManager::MergeWorkers() {
+  for (auto& worker : workers_) {
+    for (size_t i_task = 0; i_task < tasks_.size(); ++i_task) {
+      tasks_.at(i_task)->Merge(*worker.tasks.at(i_task));
+      delete worker.tasks.at(i_task);
+    }
+    delete worker.chain;
+  }
+  workers_.clear();
+}
+
+Chain* TaskManager::GetChain() const {
+  return worker_chain != nullptr ? worker_chain : chain_;
+}
+
+std::string TaskManager::GetFriendFileListName() const {
+  const auto stem = out_file_name_.size() > 5 && out_file_name_.substr(out_file_name_.size() - 5) == ".root" ? out_file_name_.substr(0, out_file_name_.size() - 5) : out_file_name_;
+  TString name = stem + ".list";
+  if (!gSystem->IsAbsoluteFileName(name)) {
+    gSystem->PrependPathName(gSystem->WorkingDirectory(), name);
+  }
+  return name.Data();
+}
+
+void TaskManager::RegisterFriendOutput() {
+  TString out_file = out_file_name_;
+  if (!gSystem->IsAbsoluteFileName(out_file)) {
+    gSystem->PrependPathName(gSystem->WorkingDirectory(), out_file);
+  }
+  const auto filelist = GetFriendFileListName();
+  std::ofstream out(filelist);
+  out << out_file.Data() << "\n";
+  out.close();
+  Chain::RegisterFriend(chain_->GetFileLists().at(0), filelist, out_tree_name_);
+  std::cout << "Output is registered as a friend of " << chain_->GetFileLists().at(0) << " with filelist " << filelist << std::endl;
+}
+
 void TaskManager::WriteCommitInfo() {
   std::string tag = std::getenv("ANALYSIS_TREE_TAG") ? std::getenv("ANALYSIS_TREE_TAG") : "unknown";
   std::string commit = std::getenv("ANALYSIS_TREE_COMMIT_HASH") ? std::getenv("ANALYSIS_TREE_COMMIT_HASH") : "unknown";
@@ -142,10 +585,24 @@ void TaskManager::PrintCommitInfo() {
 
 void TaskManager::Finish() {
 
+  MergeWorkers();
+  delete prefetcher_;
+  prefetcher_ = nullptr;
+  if (event_store_ != nullptr) {
+    event_store_->Print();
+  }
+  delete event_store_;
+  event_store_ = nullptr;
+  event_cut_branches_.clear();
+
   for (auto* task : tasks_) {
     task->Finish();
   }
 
+  if (writer_ != nullptr) {// all queued entries are filled
+    writer_->Stop();
+  }
+
   if (fill_out_tree_) {
     std::cout << "Output file is " << out_file_name_ << std::endl;
     std::cout << "Output tree is " << out_tree_name_ << std::endl;
@@ -155,15 +612,33 @@ void TaskManager::Finish() {
         std::cout << "Warining: TaskManager::Finish() - out_tree_ has friends which can be wrongly read from the output file\n";
       }
     }
+    const auto n_out_entries = out_tree_->GetEntries();
     out_tree_->Write();
     configuration_->Write("Configuration");
     data_header_->Write("DataHeader");
     if (is_write_hash_info_) WriteCommitInfo();
+    if (is_write_performance_) {
+      monitor_.Stop();
+      monitor_.Write();
+    }
     out_file_->Close();
     out_tree_ = nullptr;
+    fast_copy_fill_branches_.clear();
+    modified_branches_.clear();
+    delete writer_;// after the tree, which refers to its objects
+    writer_ = nullptr;
     delete out_file_;
     delete configuration_;
     delete data_header_;
+
+    if (write_mode_ == eBranchWriteMode::kFriendTree) {
+      if (n_out_entries == chain_->GetEntries()) {
+        RegisterFriendOutput();
+      } else {
+        std::cout << "Warning: TaskManager::Finish() - output has " << n_out_entries << " entries instead of "
+                  << chain_->GetEntries() << ", it is not registered as a friend of the input\n";
+      }
+    }
   }
 
   out_tree_name_ = "aTree";
@@ -171,6 +646,10 @@ void TaskManager::Finish() {
   is_init_ = false;
   fill_out_tree_ = false;
   read_in_tree_ = false;
+  first_entry_ = 0;
+  current_entry_ = -1;
+  current_pass_ = -1;
+  is_cache_init_ = false;
 }
 
 TaskManager::~TaskManager() {
@@ -183,12 +662,32 @@ TaskManager::~TaskManager() {
   ClearTasks();
 }
 void TaskManager::Exec() {
-  for (auto* task : tasks_) {
-    if (!task->IsGoodEvent(*chain_)) continue;
-    task->Exec();
-  }
-  if (fill_out_tree_ && is_update_entry_in_exec_) {
+  ExecTasks(*chain_, tasks_, current_pass_, is_monitor_performance_ ? &monitor_ : nullptr, event_cuts_verdicts_);
+  event_cuts_verdicts_.clear();
+  if (fill_out_tree_ && is_update_entry_in_exec_ && (current_pass_ < 0 || current_pass_ == last_pass_)) {// output is filled once per entry
     FillOutput();
   }
 }
+
+void TaskManager::FillOutput() {
+  if (!is_monitor_performance_) {
+    FillOutTree();
+    return;
+  }
+  const auto start = PerformanceMonitor::Clock::now();
+  FillOutTree();
+  monitor_.AddFill(PerformanceMonitor::GetSeconds(start, PerformanceMonitor::Clock::now()));
+}
+
+void TaskManager::FillOutTree() {
+  if (write_mode_ == eBranchWriteMode::kFastCopyTree) {// entries of other branches are already copied
+    for (auto* branch : fast_copy_fill_branches_) {
+      branch->Fill();
+    }
+  } else if (writer_ != nullptr) {
+    writer_->Fill();
+  } else {
+    out_tree_->Fill();
+  }
+}
 }// namespace AnalysisTree
@@ -6,15 +6,22 @@
 
 #include <chrono>
 #include <iostream>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "AsyncTreeWriter.hpp"
 #include "Chain.hpp"
 #include "Cuts.hpp"
+#include "EntryPrefetcher.hpp"
+#include "EventStore.hpp"
 #include "Matching.hpp"
+#include "OutputProfile.hpp"
+#include "PerformanceMonitor.hpp"
 #include "Task.hpp"
 
+class TBranch;
 class TTree;
 class TFile;
 class TChain;
@@ -26,6 +33,8 @@ class Configuration;
 enum class eBranchWriteMode {
   kCreateNewTree,
   kCopyTree,
+  kFastCopyTree,///< as kCopyTree, but compressed baskets of the input are copied, only new branches are filled
+  kFriendTree,  ///< as kCreateNewTree, and output is registered as a friend of the input, see Chain::RegisterFriend()
   kNone
 };
 
@@ -55,6 +64,13 @@ class TaskManager {
   * Initialization in case of only creating AnalysisTree
   */
   virtual void Init();
+
+  /**
+   * @brief Runs event loop over nEvents entries once per pass of the tasks (see Task::SetPass()), in increasing order.
+   * Only tasks of the current pass are executed, and Task::FinishPass() is called after each pass. Output tree is filled
+   * only in the last pass. Input Chain, its TTreeCache and pointers to branches stay open between passes and between
+   * Run() calls until Finish(), see also SetIsUseEventStore(). Several passes are not supported in parallel event loop
+   */
   virtual void Run(long long nEvents = -1);
   virtual void Finish();
 
@@ -78,11 +94,17 @@ class TaskManager {
       ptr = new BranchPtr(config.GetId());
     }
     configuration_->AddBranchConfig(config);
-    if (write_mode_ == eBranchWriteMode::kCreateNewTree) {
+    if (write_mode_ == eBranchWriteMode::kCreateNewTree || write_mode_ == eBranchWriteMode::kFriendTree) {
       chain_->GetConfiguration()->AddBranchConfig(config);
     }
 
-    out_tree_->Branch((config.GetName() + ".").c_str(), &ptr);
+    auto* branch = out_tree_->Branch((config.GetName() + ".").c_str(), &ptr, output_profile_.GetBasketSize(), output_profile_.GetSplitLevel());
+    if (write_mode_ == eBranchWriteMode::kFastCopyTree) {
+      fast_copy_fill_branches_.emplace_back(branch);
+    }
+    if (writer_ != nullptr) {
+      writer_->AddBranch(config.GetName() + ".", ptr);
+    }
   }
 
   void AddBranch(Branch* branch) {
@@ -130,12 +152,21 @@ class TaskManager {
                          configuration_->GetBranchConfig(br2).GetId());
 
     configuration_->AddMatch(match);
-    out_tree_->Branch((configuration_->GetMatchName(br1, br2) + ".").c_str(), &match);
+    auto* branch = out_tree_->Branch((configuration_->GetMatchName(br1, br2) + ".").c_str(), &match, output_profile_.GetBasketSize(), output_profile_.GetSplitLevel());
+    if (write_mode_ == eBranchWriteMode::kFastCopyTree) {
+      fast_copy_fill_branches_.emplace_back(branch);
+    }
+    if (writer_ != nullptr) {
+      writer_->AddMatching(configuration_->GetMatchName(br1, br2) + ".", match);
+    }
   }
 
-  ANALYSISTREE_ATTR_NODISCARD const Configuration* GetConfig() const { return chain_->GetConfiguration(); }
-  ANALYSISTREE_ATTR_NODISCARD const DataHeader* GetDataHeader() const { return chain_->GetDataHeader(); }
-  ANALYSISTREE_ATTR_NODISCARD Chain* GetChain() const { return chain_; }
+  ANALYSISTREE_ATTR_NODISCARD const Configuration* GetConfig() const { return GetChain()->GetConfiguration(); }
+  ANALYSISTREE_ATTR_NODISCARD const DataHeader* GetDataHeader() const { return GetChain()->GetDataHeader(); }
+  /**
+   * @brief Returns input Chain. Inside of the worker thread of parallel event loop, Chain of this worker is returned
+   */
+  ANALYSISTREE_ATTR_NODISCARD Chain* GetChain() const;
 
   ANALYSISTREE_ATTR_NODISCARD const Configuration* GetOutConfig() const { return configuration_; }
   ANALYSISTREE_ATTR_NODISCARD const DataHeader* GetOutDataHeader() const { return data_header_; }
@@ -144,7 +175,7 @@ class TaskManager {
     data_header_ = dh;
     chain_->SetDataHeader(dh);// TODO
   }
-  void FillOutput() { out_tree_->Fill(); }
+  void FillOutput();
 
   void Exec();
 
@@ -156,21 +187,205 @@ class TaskManager {
     fill_out_tree_ = true;
   }
 
+  ANALYSISTREE_ATTR_NODISCARD const std::string& GetOutputFileName() const { return out_file_name_; }
+  ANALYSISTREE_ATTR_NODISCARD const std::string& GetOutputTreeName() const { return out_tree_name_; }
+  ANALYSISTREE_ATTR_NODISCARD bool IsFillOutTree() const { return fill_out_tree_; }
+  /**
+   * @brief Absolute path of the filelist with the output file, registered as a friend in eBranchWriteMode::kFriendTree
+   */
+  ANALYSISTREE_ATTR_NODISCARD std::string GetFriendFileListName() const;
+
+  /**
+   * @brief Run() processes entries starting from first, instead of the first entry of the input
+   */
+  void SetFirstEntry(long long first) { first_entry_ = first; }
+
+  /**
+   * @brief Sets how the output tree is created. In eBranchWriteMode::kFastCopyTree all entries of the input
+   * are copied in Init() without decompression, and FillOutput() fills only branches added by tasks
+   * (and the ones set with SetBranchesModified()), so Run() should process all entries of the input.
+   * In eBranchWriteMode::kFriendTree only new branches are written, and in Finish() the output is registered
+   * as a friend of the first input filelist with Chain::RegisterFriend(), with filelist GetFriendFileListName().
+   * Next Chain created from the input filelist with SetIsReadRegisteredFriends() reads new branches as well.
+   * Run() should process all entries then too
+   */
   void SetWriteMode(eBranchWriteMode mode) { write_mode_ = mode; }
+
+  /**
+   * @brief If set, friends registered for the first input filelist with Chain::RegisterFriend()
+   * (e.g. output of eBranchWriteMode::kFriendTree) are added to the input in Init(). Off by default
+   */
+  void SetIsReadRegisteredFriends(bool is = true) { is_read_registered_friends_ = is; }
+  ANALYSISTREE_ATTR_NODISCARD bool GetIsReadRegisteredFriends() const { return is_read_registered_friends_; }
+
+  /**
+   * @brief Sets compression, basket size, auto-flush and split level of the output. Should be called before Init().
+   * The same profile is used by PlainTreeFiller, unless it has its own one
+   */
+  void SetOutputProfile(eOutputProfile profile) { output_profile_ = OutputProfile::Get(profile); }
+  void SetOutputProfile(const OutputProfile& profile) { output_profile_ = profile; }
+  ANALYSISTREE_ATTR_NODISCARD const OutputProfile& GetOutputProfile() const { return output_profile_; }
+
   void SetBranchesExclude(std::vector<std::string> brex) { branches_exclude_ = std::move(brex); }
+
+  /**
+   * @brief Input branches, which are modified by tasks in place. In eBranchWriteMode::kFastCopyTree they are
+   * written again from the objects of the input Chain instead of being copied, so they should be used by tasks.
+   * Not needed in eBranchWriteMode::kCopyTree, where all branches are written again anyway
+   */
+  void SetBranchesModified(std::vector<std::string> names) { branches_modified_ = std::move(names); }
   void SetVerbosityPeriod(int value) { verbosity_period_ = value; }
   void SetVerbosityFrequency(int value) { verbosity_frequency_ = value; }
   void SetIsWriteHashInfo(bool is = true) { is_write_hash_info_ = is; }
   void SetIsUpdateEntryInExec(bool is = true) { is_update_entry_in_exec_ = is; }
 
+  /**
+   * @brief Enables parallel event loop with n_threads worker threads. Should be called before Init().
+   * Each worker reads its own copy of the input Chain and runs its own copies of the tasks, created with Task::Clone().
+   * Events are split in contiguous ranges between workers. Copies are merged into the original tasks with Task::Merge()
+   * in Finish(). If a task does not implement Clone(), serial event loop is used.
+   * Parallel mode is available only for reading, without filling of the output tree.
+   * @param n_threads number of threads, 1 (default) means serial event loop
+   */
+  void SetNThreads(int n_threads) { n_threads_ = n_threads; }
+  ANALYSISTREE_ATTR_NODISCARD int GetNThreads() const { return n_threads_; }
+
+  /**
+   * @brief Number of the entry processed by Run() in serial event loop
+   */
+  ANALYSISTREE_ATTR_NODISCARD long long GetCurrentEntry() const { return current_entry_; }
+
+  /**
+   * @brief Pass processed by Run(), -1 outside of Run(), when Exec() executes all tasks
+   */
+  ANALYSISTREE_ATTR_NODISCARD int GetCurrentPass() const { return current_pass_; }
+
+  /**
+   * @return passes of the tasks in increasing order, {0} if there are no tasks
+   */
+  ANALYSISTREE_ATTR_NODISCARD std::vector<int> GetPasses() const;
+
+  /**
+   * @brief Enables reading of the input in a background thread: up to depth entries are decoded in advance
+   * while tasks process the current one. Should be called before Init(). Not compatible with parallel event loop
+   * and with eBranchWriteMode::kCopyTree, since the input Chain itself does not read entries in this mode.
+   * In eBranchWriteMode::kFastCopyTree prefetching can be used.
+   * @param depth number of prefetched entries, 0 (default) disables prefetching
+   * @param memory_limit if not 0, depth is reduced so that prefetched entries take not more than memory_limit bytes
+   */
+  void SetPrefetchDepth(size_t depth, size_t memory_limit = 0) {
+    prefetch_depth_ = depth;
+    prefetch_memory_limit_ = memory_limit;
+  }
+
+  /**
+   * @brief Sets size of TTreeCache of the input Chain (and of its copies in parallel event loop and prefetching).
+   * In Init() the cache of the main and friend chains is set up for input branches of the tasks
+   * (see Task::GetInputBranchNames()) and the matchings used by them, without learning phase, see Chain::InitCache().
+   * Cache efficiency and number of read calls are printed in the end of Run().
+   * Should be called before Init(). Not used in eBranchWriteMode::kCopyTree, where all branches are read
+   * @param size in bytes, 0 (default) leaves default TTreeCache of ROOT, without statistics printout
+   */
+  void SetCacheSize(long long size) { cache_size_ = size; }
+  ANALYSISTREE_ATTR_NODISCARD long long GetCacheSize() const { return cache_size_; }
+
+  /**
+   * @brief If set, pT, p, phi and eta (and energy and rapidity of particles) of all input tracks and particles are
+   * computed in one pass right after the entry is read and kept next to the branch, see Chain::GetKinematics().
+   * Useful when tasks use these quantities of every track several times. Can be changed between Run() calls
+   */
+  void SetIsCacheKinematics(bool is = true) { is_cache_kinematics_ = is; }
+  ANALYSISTREE_ATTR_NODISCARD bool GetIsCacheKinematics() const { return is_cache_kinematics_; }
+
+  /**
+   * @brief Enables EventStore: entries read in the first Run() are kept in memory, and next Run() calls between
+   * Init() and Finish() take them from memory instead of reading the input again. Should be called before Init().
+   * Not compatible with parallel event loop, prefetching and eBranchWriteMode::kCopyTree and kFastCopyTree
+   * @param memory_limit in bytes, 0 means no limit. Entries over the limit are read from the input in every pass
+   */
+  void SetIsUseEventStore(bool is = true, size_t memory_limit = 0) {
+    is_use_event_store_ = is;
+    event_store_memory_limit_ = memory_limit;
+  }
+  ANALYSISTREE_ATTR_NODISCARD const EventStore* GetEventStore() const { return event_store_; }
+
+  /**
+   * @brief Enables filling of the output tree in a background thread, see AsyncTreeWriter. FillOutput() only copies
+   * the output branch objects into a queue of up to depth entries. Entries are written in the order of FillOutput() calls.
+   * Should be called before Init(). Available only in eBranchWriteMode::kCreateNewTree and kFriendTree. Objects passed to AddBranch()
+   * and AddMatching() should not be replaced by other ones after Init()
+   * @param depth number of entries in the queue, 0 (default) means synchronous filling
+   */
+  void SetAsyncWriteDepth(size_t depth) { async_write_depth_ = depth; }
+
+  /**
+   * @brief If all tasks have event cuts, only EventHeader branches used in the cuts are read first,
+   * and other branches are read only if at least one task accepts the event. Disabled by default.
+   * Not used if output tree is filled or with prefetching, since all entries are needed then.
+   */
+  void SetIsReadEventCutsFirst(bool is = true) { is_read_event_cuts_first_ = is; }
+
+  /**
+   * @brief Enables measurement of wall and CPU time of every Task::Exec(), wall time of reading of entries
+   * and of filling of the output tree, read throughput and peak memory use. Throughput is printed
+   * together with the event number (see SetVerbosityPeriod()), full summary is printed in the end of Run()
+   * @param is_write if true, summary is also written to the output file, see PerformanceMonitor::Write()
+   */
+  void SetIsMonitorPerformance(bool is = true, bool is_write = false) {
+    is_monitor_performance_ = is;
+    is_write_performance_ = is && is_write;
+  }
+
+  ANALYSISTREE_ATTR_NODISCARD const PerformanceMonitor& GetPerformanceMonitor() const { return monitor_; }
+
   void ClearTasks() { tasks_.clear(); }
 
  protected:
   TaskManager() = default;
   static TaskManager* manager_;
 
+  /**
+   * @brief Input Chain and copies of the tasks of one worker in parallel event loop
+   */
+  struct Worker {
+    Chain* chain{nullptr};
+    std::vector<Task*> tasks{};
+    PerformanceMonitor monitor{};
+  };
+
+  /**
+   * @brief Throws if the options set before Init() (threads, prefetching, event store, write mode, etc.) cannot be used together
+   */
+  void ValidateRunConfiguration() const;
   void InitOutChain();
   void InitTasks();
+  void InitWorkers(const std::set<std::string>& branch_names);
+  void InitPrefetcher(const std::set<std::string>& branch_names);
+  void InitEventCutBranches();
+  void InitEventStore();
+  /**
+   * @return true if TTreeCache of the chain is set up, see SetCacheSize()
+   */
+  bool InitCache(Chain* chain) const;
+  void FillOutTree();
+  void RegisterFriendOutput();
+  /**
+   * @brief Reads the entry, evaluating event cuts of the tasks first if possible
+   * @param verdicts result of event cuts of every task if they were evaluated, empty otherwise
+   * @return false if the event is rejected by all tasks and was not read completely
+   */
+  bool ReadEntry(Chain* chain, const std::vector<Task*>& tasks, long long entry, PerformanceMonitor* monitor,
+                 std::vector<char>& verdicts) const;
+  /**
+   * @brief Executes tasks of the pass, or all tasks if pass is negative
+   * @param verdicts result of event cuts from ReadEntry(), if empty the cuts are evaluated here
+   */
+  static void ExecTasks(const Chain& chain, const std::vector<Task*>& tasks, int pass, PerformanceMonitor* monitor,
+                        const std::vector<char>& verdicts);
+  void StartMonitors();
+  void RunPass(long long nEvents);
+  void RunParallel(long long nEvents);
+  void MergeWorkers();
   static void WriteCommitInfo();
   static void PrintCommitInfo();
 
@@ -186,10 +401,41 @@ class TaskManager {
   std::string out_tree_name_{"aTree"};
   std::string out_file_name_{"analysis_tree.root"};
   std::vector<std::string> branches_exclude_{};
+  std::vector<std::string> branches_modified_{};
+  OutputProfile output_profile_{};
+
+  std::map<std::string, BranchPointer> modified_branches_{};//! objects of the input Chain written in kFastCopyTree
+  std::vector<TBranch*> fast_copy_fill_branches_{};        //! branches filled in kFastCopyTree, others are copied
 
   int verbosity_period_{-1};
   int verbosity_frequency_{-1};
 
+  long long first_entry_{0};
+  long long current_entry_{-1};
+  int current_pass_{-1};
+  int last_pass_{0};
+
+  int n_threads_{1};
+  std::vector<Worker> workers_{};//! workers of parallel event loop, except the main thread one
+
+  size_t prefetch_depth_{0};
+  size_t prefetch_memory_limit_{0};
+  EntryPrefetcher* prefetcher_{nullptr};//!
+
+  size_t async_write_depth_{0};
+  AsyncTreeWriter* writer_{nullptr};//!
+
+  std::vector<std::string> event_cut_branches_{};//! read before the rest of the entry
+  std::vector<char> event_cuts_verdicts_{};       //! event cuts of the tasks evaluated in ReadEntry() for the current entry
+
+  long long cache_size_{0};
+  bool is_cache_init_{false};//!
+
+  size_t event_store_memory_limit_{0};
+  EventStore* event_store_{nullptr};//!
+
+  PerformanceMonitor monitor_{};//!
+
   // configuration parameters
   eBranchWriteMode write_mode_{eBranchWriteMode::kCreateNewTree};
   bool is_init_{false};
@@ -198,6 +444,12 @@ class TaskManager {
   bool read_in_tree_{false};
   bool is_owns_tasks_{true};
   bool is_write_hash_info_{true};
+  bool is_read_event_cuts_first_{false};
+  bool is_use_event_store_{false};
+  bool is_cache_kinematics_{false};
+  bool is_read_registered_friends_{false};
+  bool is_monitor_performance_{false};
+  bool is_write_performance_{false};
 
   ClassDef(TaskManager, 0);
 };
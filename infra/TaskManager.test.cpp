@@ -4,10 +4,15 @@ Authors: Viktor Klochkov */
 #ifndef ANALYSISTREE_INFRA_TASKMANANGER_TEST_HPP_
 #define ANALYSISTREE_INFRA_TASKMANANGER_TEST_HPP_
 
+#include "ShardedRunner.hpp"
 #include "TaskManager.hpp"
 #include "ToyMC.hpp"
+
+#include <TTreeCache.h>
 #include <gtest/gtest.h>
 
+#include <fstream>
+
 namespace {
 
 using namespace AnalysisTree;
@@ -38,6 +43,95 @@ class TestTask : public Task {
   Branch sim_;
 };
 
+class CountingTask : public Task {
+ public:
+  CountingTask() { AddInputBranch("RecTracks"); }
+
+  void Init() override {
+    rec_ = TaskManager::GetInstance()->GetChain()->GetBranchObject("RecTracks");
+  }
+
+  void Exec() override {
+    n_events_++;
+    n_tracks_ += rec_.size();
+  }
+
+  void Finish() override {}
+
+  Task* Clone() const override { return new CountingTask(*this); }
+
+  void Merge(const Task& other) override {
+    const auto& task = dynamic_cast<const CountingTask&>(other);
+    n_events_ += task.n_events_;
+    n_tracks_ += task.n_tracks_;
+  }
+
+  long long n_events_{0};
+  long long n_tracks_{0};
+
+ protected:
+  Branch rec_;
+};
+
+class MultiplicityTask : public Task {
+ public:
+  MultiplicityTask() {
+    AddInputBranch("RecTracks");
+    AddInputBranch("SimParticles");
+  }
+
+  void Init() override {
+    auto* man = TaskManager::GetInstance();
+    rec_ = man->GetChain()->GetBranchObject("RecTracks");
+
+    BranchConfig config("Multiplicity", DetType::kEventHeader);
+    config.AddField<int>("n_tracks", "number of RecTracks");
+    multiplicity_ = Branch(config);
+    multiplicity_.SetMutable();
+    man->AddBranch(&multiplicity_);
+    n_tracks_ = multiplicity_.GetField("n_tracks");
+  }
+
+  void Exec() override {
+    multiplicity_[0].SetValue(n_tracks_, rec_.size());
+  }
+
+  void Finish() override {}
+
+ protected:
+  Branch rec_;
+  Branch multiplicity_;
+  Field n_tracks_;
+};
+
+class SerialCountingTask : public CountingTask {
+ public:
+  Task* Clone() const override { return nullptr; }
+};
+
+class MeanMultiplicityTask : public CountingTask {
+ public:
+  void FinishPass() override { mean_ = double(n_tracks_) / n_events_; }
+
+  double mean_{-1.};
+};
+
+class HighMultiplicityTask : public CountingTask {
+ public:
+  explicit HighMultiplicityTask(const MeanMultiplicityTask* calibration) : calibration_(calibration) { SetPass(1); }
+
+  void Exec() override {
+    ASSERT_GE(calibration_->mean_, 0.);// result of the first pass
+    CountingTask::Exec();
+    if (rec_.size() > calibration_->mean_) n_high_++;
+  }
+
+  long long n_high_{0};
+
+ protected:
+  const MeanMultiplicityTask* calibration_{nullptr};
+};
+
 TEST(TaskManager, RemoveBranch) {
 
   const int n_events = 1000;
@@ -54,6 +148,9 @@ TEST(TaskManager, RemoveBranch) {
   man->Init({filelist}, {"tTree"});
   man->Run(-1);
   man->Finish();
+  man->ClearTasks();
+  man->SetWriteMode(eBranchWriteMode::kCreateNewTree);
+  man->SetBranchesExclude({});
 
   Chain t1(std::vector<std::string>{filelist}, {"tTree"});
   Chain t2("test.root", "tTree");
@@ -79,6 +176,534 @@ TEST(TaskManager, RemoveBranch) {
   }
 }
 
+TEST(TaskManager, ParallelRun) {
+
+  const int n_events = 1000;
+  const std::string filelist = "fl_test_task_manager_parallel.txt";
+
+  RunToyMC(n_events, filelist);
+
+  TaskManager* man = TaskManager::GetInstance();
+  man->ClearTasks();
+
+  auto* serial_task = new CountingTask;
+  man->AddTask(serial_task);
+  man->Init({filelist}, {"tTree"});
+  man->Run(-1);
+  man->Finish();
+  man->ClearTasks();
+
+  auto* parallel_task = new CountingTask;
+  man->AddTask(parallel_task);
+  man->SetNThreads(4);
+  man->Init({filelist}, {"tTree"});
+  man->Run(-1);
+  man->Finish();
+  man->ClearTasks();
+
+  auto* not_cloned_task = new SerialCountingTask;// serial event loop is used
+  man->AddTask(not_cloned_task);
+  man->Init({filelist}, {"tTree"});
+  man->Run(-1);
+  man->Finish();
+  man->SetNThreads(1);
+  man->ClearTasks();
+
+  ASSERT_EQ(serial_task->n_events_, n_events);
+  ASSERT_EQ(parallel_task->n_events_, n_events);
+  ASSERT_EQ(serial_task->n_tracks_, parallel_task->n_tracks_);
+  ASSERT_EQ(not_cloned_task->n_events_, n_events);
+  ASSERT_EQ(not_cloned_task->n_tracks_, serial_task->n_tracks_);
+
+  delete serial_task;
+  delete parallel_task;
+  delete not_cloned_task;
+}
+
+TEST(TaskManager, PrefetchRun) {
+
+  const int n_events = 1000;
+  const std::string filelist = "fl_test_task_manager_prefetch.txt";
+
+  RunToyMC(n_events, filelist);
+
+  TaskManager* man = TaskManager::GetInstance();
+  man->ClearTasks();
+
+  auto* serial_task = new CountingTask;
+  man->AddTask(serial_task);
+  man->Init({filelist}, {"tTree"});
+  man->Run(-1);
+  man->Finish();
+  man->ClearTasks();
+
+  auto* prefetch_task = new CountingTask;
+  man->AddTask(prefetch_task);
+  man->SetPrefetchDepth(4);
+  man->Init({filelist}, {"tTree"});
+  man->Run(-1);
+  man->Finish();
+  man->SetPrefetchDepth(0);
+  man->ClearTasks();
+
+  ASSERT_EQ(prefetch_task->n_events_, n_events);
+  ASSERT_EQ(serial_task->n_tracks_, prefetch_task->n_tracks_);
+
+  delete serial_task;
+  delete prefetch_task;
+}
+
+TEST(TaskManager, EventStore) {
+
+  const int n_events = 500;
+  const std::string filelist = "fl_test_task_manager_event_store.txt";
+
+  RunToyMC(n_events, filelist);
+
+  TaskManager* man = TaskManager::GetInstance();
+  man->ClearTasks();
+
+  for (size_t memory_limit : {size_t(0), size_t(100000)}) {
+    auto* task = new CountingTask;
+    man->AddTask(task);
+    man->SetIsUseEventStore(true, memory_limit);
+    man->Init({filelist}, {"tTree"});
+    man->Run(-1);
+    const auto n_tracks_first = task->n_tracks_;
+    ASSERT_NE(man->GetEventStore(), nullptr);
+    if (memory_limit == 0) {
+      ASSERT_EQ(man->GetEventStore()->GetNumberOfEntries(), n_events);
+    } else {
+      ASSERT_TRUE(man->GetEventStore()->IsFull());
+      ASSERT_LE(man->GetEventStore()->GetMemoryUsage(), memory_limit);
+      ASSERT_EQ(man->GetEventStore()->GetNumberOfEntries() + man->GetEventStore()->GetNumberOfRefused(), n_events);
+    }
+    const auto n_refused_first = man->GetEventStore()->GetNumberOfRefused();
+    man->Run(-1);// second pass, stored entries are not read from the input
+    ASSERT_EQ(man->GetEventStore()->GetNumberOfRefused(), n_refused_first);// refused entries are counted once
+    man->Finish();
+    man->SetIsUseEventStore(false);
+    man->ClearTasks();
+
+    ASSERT_EQ(task->n_events_, 2 * n_events);
+    ASSERT_EQ(task->n_tracks_, 2 * n_tracks_first);
+    delete task;
+  }
+}
+
+TEST(TaskManager, MultiPass) {
+
+  const int n_events = 300;
+  const std::string filelist = "fl_test_task_manager_multi_pass.txt";
+
+  RunToyMC(n_events, filelist);
+
+  TaskManager* man = TaskManager::GetInstance();
+  man->ClearTasks();
+  auto* calibration = new MeanMultiplicityTask;
+  auto* analysis = new HighMultiplicityTask(calibration);
+  auto* output = new MultiplicityTask;
+  output->SetPass(1);
+  man->AddTask(analysis);// order of tasks does not matter
+  man->AddTask(calibration);
+  man->AddTask(output);
+  man->SetOutputName("test_multi_pass.root", "pTree");
+  man->SetIsUseEventStore(true);
+  man->Init({filelist}, {"tTree"});
+  ASSERT_EQ(man->GetPasses(), std::vector<int>({0, 1}));
+  man->Run(-1);
+  ASSERT_EQ(man->GetCurrentPass(), -1);
+  ASSERT_EQ(man->GetEventStore()->GetNumberOfEntries(), n_events);// second pass is not read from the input
+  man->Finish();
+  man->SetIsUseEventStore(false);
+  man->ClearTasks();
+
+  ASSERT_EQ(calibration->n_events_, n_events);
+  ASSERT_EQ(analysis->n_events_, n_events);
+  ASSERT_EQ(analysis->n_tracks_, calibration->n_tracks_);
+  ASSERT_GT(analysis->n_high_, 0);
+  ASSERT_LT(analysis->n_high_, n_events);
+
+  {
+    TFile file("test_multi_pass.root", "read");
+    auto* tree = (TTree*) file.Get("pTree");
+    ASSERT_NE(tree, nullptr);
+    ASSERT_EQ(tree->GetEntries(), n_events);// filled only in the last pass
+  }
+  delete calibration;
+  delete analysis;
+  delete output;
+}
+
+TEST(TaskManager, TreeCache) {
+
+  const int n_events = 300;
+  const std::string filelist = "fl_test_task_manager_tree_cache.txt";
+
+  RunToyMC(n_events, filelist);
+
+  TaskManager* man = TaskManager::GetInstance();
+  man->ClearTasks();
+  const auto default_size = man->GetCacheSize();
+  auto* task = new CountingTask;
+  man->AddTask(task);
+  man->SetCacheSize(1024 * 1024);
+  man->Init({filelist}, {"tTree"});
+  man->Run(-1);
+
+  auto* chain = man->GetChain();
+  auto* cache = chain->GetReadCache(chain->GetCurrentFile());
+  ASSERT_NE(cache, nullptr);
+  ASSERT_FALSE(cache->IsLearning());
+  const auto* cached = cache->GetCachedBranches();
+  ASSERT_GT(cached->GetEntries(), 0);
+  for (int i = 0; i < cached->GetEntries(); ++i) {// only input of the task
+    ASSERT_EQ(std::string(cached->At(i)->GetName()).rfind("RecTracks", 0), 0);
+  }
+  const auto stats = chain->GetCacheStats();
+  ASSERT_EQ(stats.n_cached_branches, cached->GetEntries());
+  ASSERT_GT(stats.read_calls, 0);
+  ASSERT_GT(stats.bytes_read, 0);
+  ASSERT_GT(stats.hit_ratio, 0.);
+  ASSERT_LE(stats.hit_ratio, 1.);
+
+  man->Finish();
+  man->SetCacheSize(default_size);
+  man->ClearTasks();
+  ASSERT_EQ(task->n_events_, n_events);
+  delete task;
+}
+
+TEST(TaskManager, DemandDrivenBranches) {
+
+  const std::string filelist = "fl_test_task_manager_demand.txt";
+  RunToyMC(100, filelist);
+
+  Chain chain(std::vector<std::string>{filelist}, {"tTree"});
+  chain.InitPointersToBranches({"RecTracks"});
+
+  EXPECT_TRUE(chain.GetMatchPointers().empty());
+  EXPECT_EQ(chain.GetBranchPointers().size(), 1);
+  EXPECT_GT(chain.GetSkippedBytesPerEvent(), 0.);
+
+  const auto& const_chain = chain;
+  EXPECT_THROW((void) const_chain.GetMatching("RecTracks", "SimParticles"), std::runtime_error);// not loaded yet
+
+  auto* match = chain.GetMatching("RecTracks", "SimParticles");
+  EXPECT_EQ(chain.GetMatchPointers().size(), 1);
+  EXPECT_EQ(chain.GetMatching("RecTracks", "SimParticles"), match);
+  EXPECT_EQ(const_chain.GetMatching("RecTracks", "SimParticles"), match);
+
+  auto rec = chain.GetBranchObject("RecTracks");
+  chain.GetEntry(0);
+  EXPECT_GT(rec.size(), 0);
+  EXPECT_EQ(match->GetMatches().size(), rec.size());
+
+  Chain chain_both(std::vector<std::string>{filelist}, {"tTree"});
+  chain_both.InitPointersToBranches({"RecTracks", "SimParticles"});
+  EXPECT_EQ(chain_both.GetMatchPointers().size(), 1);
+}
+
+TEST(TaskManager, EventCutsFirst) {
+
+  const int n_events = 1000;
+  const std::string filelist = "fl_test_task_manager_event_cuts.txt";
+
+  RunToyMC(n_events, filelist);
+
+  Cuts event_cuts("event_cuts", {RangeCut("SimEventHeader.psi_RP", 0., 1.)});
+
+  TaskManager* man = TaskManager::GetInstance();
+  man->ClearTasks();
+
+  auto* full_task = new CountingTask;
+  full_task->AddInputBranch("SimEventHeader");
+  full_task->SetEventCuts(&event_cuts);
+  man->AddTask(full_task);
+  man->SetIsReadEventCutsFirst(false);
+  man->Init({filelist}, {"tTree"});
+  man->Run(-1);
+  man->Finish();
+  man->ClearTasks();
+
+  auto* two_phase_task = new CountingTask;
+  two_phase_task->AddInputBranch("SimEventHeader");
+  two_phase_task->SetEventCuts(&event_cuts);
+  man->AddTask(two_phase_task);
+  man->SetIsReadEventCutsFirst(true);
+  man->Init({filelist}, {"tTree"});
+  man->Run(-1);
+  man->Finish();
+  man->ClearTasks();
+  man->SetIsReadEventCutsFirst(false);
+
+  ASSERT_GT(full_task->n_events_, 0);
+  ASSERT_LT(full_task->n_events_, n_events);
+  ASSERT_EQ(full_task->n_events_, two_phase_task->n_events_);
+  ASSERT_EQ(full_task->n_tracks_, two_phase_task->n_tracks_);
+
+  delete full_task;
+  delete two_phase_task;
+}
+
+TEST(TaskManager, MonitorPerformance) {
+
+  const int n_events = 100;
+  const std::string filelist = "fl_test_task_manager_monitor.txt";
+
+  RunToyMC(n_events, filelist);
+
+  TaskManager* man = TaskManager::GetInstance();
+  man->ClearTasks();
+
+  auto* task = new CountingTask;
+  man->AddTask(task);
+  man->SetOutputName("test_monitor.root", "aTree");
+  man->SetIsMonitorPerformance(true, true);
+  man->Init({filelist}, {"tTree"});
+  man->Run(-1);
+
+  const auto& monitor = man->GetPerformanceMonitor();
+  EXPECT_EQ(monitor.GetNEvents(), n_events);
+  EXPECT_EQ(monitor.GetRead().wall.GetEntries(), n_events);
+  EXPECT_EQ(monitor.GetFill().wall.GetEntries(), n_events);
+  ASSERT_EQ(monitor.GetTasks().size(), 1);
+  EXPECT_EQ(monitor.GetTasks().at(0).wall.GetEntries(), n_events);
+
+  man->Finish();
+  man->SetIsMonitorPerformance(false);
+  man->ClearTasks();
+  delete task;
+
+  TFile file("test_monitor.root", "read");
+  auto* summary = (TTree*) file.Get("PerformanceSummary");
+  ASSERT_NE(summary, nullptr);
+  EXPECT_EQ(summary->GetEntries(), 3);// task, GetEntry, Fill
+  EXPECT_NE(file.Get("PerformanceSummary_text"), nullptr);
+}
+
+TEST(TaskManager, ShardedRun) {
+
+  const int n_events = 300;
+  const std::string filelist = "fl_test_task_manager_sharded.txt";
+
+  RunToyMC(n_events, filelist);
+
+  TaskManager* man = TaskManager::GetInstance();
+  man->ClearTasks();
+
+  auto* task = new TestTask;
+  man->AddTask(task);
+  man->SetWriteMode(eBranchWriteMode::kCopyTree);
+  man->SetOutputName("test_sharded.root", "aTree");
+
+  ShardedRunner runner(3, eShardMode::kEntries);
+  runner.Run({filelist}, {"tTree"});
+  man->ClearTasks();
+  man->SetWriteMode(eBranchWriteMode::kCreateNewTree);
+  delete task;
+
+  ASSERT_EQ(runner.GetShardFileNames().size(), 3);
+
+  Chain input(std::vector<std::string>{filelist}, {"tTree"});
+  Chain merged("test_sharded.root", "aTree");
+  ASSERT_EQ(merged.GetEntries(), n_events);
+  ASSERT_NE(merged.GetConfiguration(), nullptr);
+  ShardedRunner::CheckConsistency(*input.GetConfiguration(), *merged.GetConfiguration(), "test_sharded.root");
+
+  input.InitPointersToBranches({"RecTracks"});
+  merged.InitPointersToBranches({"RecTracks"});
+  auto rec_input = input.GetBranchObject("RecTracks");
+  auto rec_merged = merged.GetBranchObject("RecTracks");
+  for (long long i = 0; i < n_events; i += 50) {
+    input.GetEntry(i);
+    merged.GetEntry(i);
+    ASSERT_EQ(rec_input.size(), rec_merged.size());
+  }
+
+  Configuration other("Configuration");
+  other.AddBranchConfig(BranchConfig("RecTracks", DetType::kTrack));
+  EXPECT_THROW(ShardedRunner::CheckConsistency(*input.GetConfiguration(), other, "other"), std::runtime_error);
+}
+
+TEST(TaskManager, FastCopyTree) {
+
+  const int n_events = 500;
+  const std::string filelist = "fl_test_task_manager_fast_copy.txt";
+
+  RunToyMC(n_events, filelist);
+
+  TaskManager* man = TaskManager::GetInstance();
+  man->ClearTasks();
+  auto* task = new MultiplicityTask;
+  man->AddTask(task);
+  man->SetWriteMode(eBranchWriteMode::kFastCopyTree);
+  man->SetBranchesModified({"SimParticles"});
+  man->SetOutputName("test_fast_copy.root", "aTree");
+  man->Init({filelist}, {"tTree"});
+  EXPECT_THROW(man->Run(n_events / 2), std::runtime_error);
+  man->Run(-1);
+  man->Finish();
+  man->ClearTasks();
+  man->SetWriteMode(eBranchWriteMode::kCreateNewTree);
+  man->SetBranchesModified({});
+  delete task;
+
+  Chain input(std::vector<std::string>{filelist}, {"tTree"});
+  Chain output("test_fast_copy.root", "aTree");
+  ASSERT_EQ(output.GetEntries(), n_events);
+  ASSERT_NO_THROW(output.GetConfiguration()->GetBranchConfig("Multiplicity"));
+
+  input.InitPointersToBranches({});
+  output.InitPointersToBranches({});
+  auto rec_input = input.GetBranchObject("RecTracks");
+  auto rec_output = output.GetBranchObject("RecTracks");
+  auto sim_input = input.GetBranchObject("SimParticles");
+  auto sim_output = output.GetBranchObject("SimParticles");
+  auto multiplicity = output.GetBranchObject("Multiplicity");
+  auto n_tracks = multiplicity.GetField("n_tracks");
+
+  for (long long i = 0; i < n_events; i += 10) {
+    input.GetEntry(i);
+    output.GetEntry(i);
+    ASSERT_EQ(rec_input.size(), rec_output.size());
+    for (size_t j = 0; j < rec_input.size(); ++j) {
+      ASSERT_EQ(*(rec_input[j].Data<Track>()), *(rec_output[j].Data<Track>()));
+    }
+    ASSERT_EQ(sim_input.size(), sim_output.size());
+    ASSERT_EQ(static_cast<size_t>(multiplicity[0][n_tracks]), rec_input.size());
+  }
+}
+
+TEST(TaskManager, FriendTree) {
+
+  const int n_events = 200;
+  const std::string filelist = "fl_test_task_manager_friend.txt";
+
+  RunToyMC(n_events, filelist);
+
+  TaskManager* man = TaskManager::GetInstance();
+  man->ClearTasks();
+  auto* task = new MultiplicityTask;
+  man->AddTask(task);
+  for (int i_run = 0; i_run < 2; ++i_run) {// second run replaces the output of the first one
+    man->SetWriteMode(eBranchWriteMode::kFriendTree);
+    man->SetOutputName("test_friend.root", "fTree");
+    man->Init({filelist}, {"tTree"});
+    man->Run(-1);
+    man->Finish();
+  }
+  man->ClearTasks();
+  man->SetWriteMode(eBranchWriteMode::kCreateNewTree);
+  delete task;
+
+  const auto friends = Chain::GetRegisteredFriends(filelist);
+  ASSERT_EQ(friends.size(), 1);
+  ASSERT_EQ(friends.at(0).second, "fTree");
+
+  {
+    TFile file("test_friend.root", "read");
+    auto* tree = (TTree*) file.Get("fTree");
+    ASSERT_NE(tree, nullptr);
+    ASSERT_EQ(tree->GetListOfBranches()->GetEntries(), 1);// only new branch
+  }
+
+  Chain chain_without_friends(std::vector<std::string>{filelist}, {"tTree"});// registry is read only on request
+  ASSERT_EQ(chain_without_friends.GetFileLists().size(), 1);
+
+  const std::string double_filelist = "fl_test_task_manager_friend_double.txt";
+  {
+    std::ofstream out(double_filelist);// twice as many entries as the input, skipped with a warning
+    out << "toymc_analysis_task.root\ntoymc_analysis_task.root\n";
+  }
+  Chain::RegisterFriend(filelist, double_filelist, "tTree");
+
+  Chain chain(std::vector<std::string>{filelist}, {"tTree"}, true);
+  ASSERT_EQ(chain.GetFileLists().size(), 2);
+  ASSERT_EQ(chain.GetFileLists().at(1), friends.at(0).first);
+  Chain::UnregisterFriend(filelist, double_filelist);
+  chain.InitPointersToBranches({"RecTracks", "Multiplicity"});
+  auto rec = chain.GetBranchObject("RecTracks");
+  auto multiplicity = chain.GetBranchObject("Multiplicity");
+  auto n_tracks = multiplicity.GetField("n_tracks");
+  for (long long i = 0; i < n_events; i += 10) {
+    chain.GetEntry(i);
+    ASSERT_EQ(static_cast<size_t>(multiplicity[0][n_tracks]), rec.size());
+  }
+
+  Chain::UnregisterFriend(filelist, friends.at(0).first);
+  ASSERT_TRUE(Chain::GetRegisteredFriends(filelist).empty());
+}
+
+TEST(TaskManager, AsyncWrite) {
+
+  const int n_events = 200;
+
+  auto run_toy_mc = [n_events](const std::string& filename, size_t depth) {
+    auto* man = TaskManager::GetInstance();
+    man->ClearTasks();
+    auto* toy_mc = new ToyMC<std::default_random_engine>;
+    man->AddTask(toy_mc);
+    man->SetOutputName(filename, "tTree");
+    man->SetAsyncWriteDepth(depth);
+    man->Init();
+    man->Run(n_events);
+    man->Finish();
+    man->SetAsyncWriteDepth(0);
+    man->ClearTasks();
+    delete toy_mc;
+  };
+  run_toy_mc("toymc_sync.root", 0);
+  run_toy_mc("toymc_async.root", 4);
+
+  Chain sync("toymc_sync.root", "tTree");
+  Chain async("toymc_async.root", "tTree");
+  ASSERT_EQ(sync.GetEntries(), n_events);
+  ASSERT_EQ(async.GetEntries(), n_events);
+
+  sync.InitPointersToBranches({});
+  async.InitPointersToBranches({});
+  auto sync_tracks = sync.GetBranchObject("RecTracks");
+  auto async_tracks = async.GetBranchObject("RecTracks");
+  auto* sync_match = sync.GetMatching("RecTracks", "SimParticles");
+  auto* async_match = async.GetMatching("RecTracks", "SimParticles");
+
+  for (long long i = 0; i < n_events; ++i) {
+    sync.GetEntry(i);
+    async.GetEntry(i);
+    ASSERT_EQ(sync_tracks.size(), async_tracks.size());
+    for (size_t j = 0; j < sync_tracks.size(); ++j) {
+      ASSERT_EQ(*(sync_tracks[j].Data<Track>()), *(async_tracks[j].Data<Track>()));
+    }
+    ASSERT_EQ(sync_match->GetMatches(), async_match->GetMatches());
+  }
+}
+
+TEST(TaskManager, OutputProfile) {
+
+  auto* man = TaskManager::GetInstance();
+  man->ClearTasks();
+  auto* toy_mc = new ToyMC<std::default_random_engine>;
+  man->AddTask(toy_mc);
+  man->SetOutputName("toymc_profile.root", "tTree");
+  man->SetOutputProfile(eOutputProfile::kAnalysis);
+  man->Init();
+  man->Run(10);
+  man->Finish();
+  man->SetOutputProfile(eOutputProfile::kDefault);
+  man->ClearTasks();
+  delete toy_mc;
+
+  const auto profile = OutputProfile::Get(eOutputProfile::kAnalysis);
+  TFile file("toymc_profile.root", "read");
+  auto* tree = (TTree*) file.Get("tTree");
+  ASSERT_NE(tree, nullptr);
+  auto* branch = tree->GetBranch("RecTracks.");
+  ASSERT_NE(branch, nullptr);
+  EXPECT_EQ(branch->GetCompressionSettings(), profile.compression);
+  EXPECT_EQ(branch->GetBasketSize(), profile.basket_size);
+}
+
 }// namespace
 
 #endif//ANALYSISTREE_INFRA_TASKMANANGER_TEST_HPP_
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <regex>
 
+#include "Branch.hpp"
 #include "Configuration.hpp"
 
 #include <iostream>
@@ -16,7 +17,8 @@ Variable::Variable(std::string name, std::vector<Field> fields, std::function<do
     : name_(std::move(name)),
       fields_(std::move(fields)),
       lambda_(std::move(lambda)),
-      n_branches_(GetBranches().size()) {
+      n_branches_(GetBranches().size()),
+      is_lambda_(true) {
 }
 
 void Variable::Init(const Configuration& conf) {
@@ -62,6 +64,20 @@ Variable Variable::FromString(const std::string& full_name) {
   throw std::runtime_error("Field name must be in the format <branch>.<name>");
 }
 
+Variable Variable::FromExpression(const std::string& formula, std::string name) {
+  Expression expression(formula);
+  std::vector<Field> fields;
+  for (const auto& field_name : expression.GetFieldNames()) {
+    fields.emplace_back(FromString(field_name).GetFields().at(0));
+  }
+  if (name.empty()) {
+    name = expression.GetCanonical();
+  }
+  Variable var(std::move(name), std::move(fields), [expression](std::vector<double>& args) { return expression.Evaluate(args); });
+  var.expression_ = std::move(expression);
+  return var;
+}
+
 double Variable::GetValue(const BranchChannel& object) const {
   assert(is_init_ && n_branches_ == 1);
   vars_.clear();
@@ -93,6 +109,48 @@ double Variable::GetValue(std::vector<const BranchChannel*>& bch, std::vector<si
   return lambda_(vars_);
 }
 
+void Variable::Bind(const std::vector<size_t>& branch_ids) {
+  assert(is_init_);
+  slots_.clear();
+  for (const auto& field : fields_) {
+    auto it = std::find(branch_ids.begin(), branch_ids.end(), field.GetBranchId());
+    if (it == branch_ids.end()) {
+      throw std::runtime_error("Variable::Bind - Cannot find branch " + field.GetBranchName() + " for variable " + name_);
+    }
+    slots_.emplace_back(std::distance(branch_ids.begin(), it));
+  }
+}
+
+double Variable::GetBoundValue(const std::vector<const BranchChannel*>& bch) const {
+  assert(is_init_ && slots_.size() == fields_.size());
+  vars_.clear();
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    vars_.emplace_back(bch[slots_[i]]->Value(fields_[i]));
+  }
+  return lambda_(vars_);
+}
+
+void Variable::GetValues(const Branch& branch, size_t first, size_t last, double* out) const {
+  assert(is_init_ && n_branches_ == 1);
+  const auto n_channels = last - first;
+  const auto n_fields = fields_.size();
+  columns_.resize(n_fields * n_channels);
+  for (size_t i_field = 0; i_field < n_fields; ++i_field) {
+    branch.GetFieldValues(fields_[i_field], first, n_channels, columns_.data() + i_field * n_channels);
+  }
+  if (!expression_.IsEmpty()) {
+    expression_.EvaluateBatch(columns_.data(), n_channels, out);
+    return;
+  }
+  vars_.resize(n_fields);
+  for (size_t i_channel = 0; i_channel < n_channels; ++i_channel) {
+    for (size_t i_field = 0; i_field < n_fields; ++i_field) {
+      vars_[i_field] = columns_[i_field * n_channels + i_channel];
+    }
+    out[i_channel] = lambda_(vars_);
+  }
+}
+
 double Variable::GetValue(const BranchChannel& a, size_t a_id, const BranchChannel& b, size_t b_id) const {
   BranchChannel* a_ptr = new BranchChannel(std::move(a));
   BranchChannel* b_ptr = new BranchChannel(std::move(b));
@@ -111,6 +169,18 @@ std::string Variable::GetBranchName() const {
   return fields_.at(0).GetBranchName();
 }
 
+std::string Variable::GetDefinition() const {
+  std::string result = expression_.IsEmpty() ? name_ : expression_.GetCanonical();
+  if (expression_.IsEmpty() && !version_.empty()) {
+    result += "#" + version_;
+  }
+  result += "(";
+  for (const auto& field : fields_) {
+    result += field.GetBranchName() + "." + field.GetName() + ",";
+  }
+  return result + ")";
+}
+
 std::set<std::string> Variable::GetBranches() const {
   std::set<std::string> branches{};
   for (const auto& field : fields_) {
@@ -12,6 +12,7 @@
 #include <utility>
 
 #include "BranchChannel.hpp"
+#include "Expression.hpp"
 #include "Field.hpp"
 
 namespace AnalysisTree {
@@ -51,6 +52,14 @@ class Variable {
    */
   static Variable FromString(const std::string& full_name);
 
+  /**
+   * @brief Creates Variable from a formula of fields, see Expression for the syntax.
+   * Example: Variable::FromExpression("sqrt(VtxTracks.px^2 + VtxTracks.py^2)")
+   * @param name name of the Variable. If empty, the canonical form of the formula is used, so that
+   * Variables defined by the same formula are equal and can be shared, e.g. in AnalysisEntry::AddVariable()
+   */
+  static Variable FromExpression(const std::string& formula, std::string name = "");
+
   friend bool operator==(const Variable& that, const Variable& other);
   friend bool operator>(const Variable& that, const Variable& other);
   friend bool operator<(const Variable& that, const Variable& other);
@@ -62,8 +71,47 @@ class Variable {
   ANALYSISTREE_ATTR_NODISCARD short GetNumberOfBranches() const { return n_branches_; }
   ANALYSISTREE_ATTR_NODISCARD std::set<std::string> GetBranches() const;
   ANALYSISTREE_ATTR_NODISCARD std::string GetBranchName() const;
+  /**
+   * @brief Identifies the computation: canonical formula for Variables created with FromExpression(), otherwise
+   * name, version of the lambda (see SetVersion()) and names of fields
+   */
+  ANALYSISTREE_ATTR_NODISCARD std::string GetDefinition() const;
+
+  /**
+   * @brief Sets version of the lambda, which is a part of GetDefinition(). Lambda itself cannot be compared,
+   * so the version should be changed together with the lambda
+   */
+  void SetVersion(std::string version) { version_ = std::move(version); }
+  ANALYSISTREE_ATTR_NODISCARD const std::string& GetVersion() const { return version_; }
+
+  /**
+   * @return true if GetDefinition() identifies the computation: Variable of one field, created with FromExpression()
+   * or with the version of its lambda set. Required by ColumnCache
+   */
+  ANALYSISTREE_ATTR_NODISCARD bool IsDefinitionComplete() const { return !is_lambda_ || !expression_.IsEmpty() || !version_.empty(); }
 
   double GetValue(std::vector<const BranchChannel*>& bch, std::vector<size_t>& id) const;
+
+  /**
+   * @brief Resolves each Field to the position of its branch in branch_ids, so that GetBoundValue()
+   * does not need to search for the branch. Called once after Init()
+   * @param branch_ids ids of the branches in the same order as BranchChannels passed to GetBoundValue()
+   */
+  void Bind(const std::vector<size_t>& branch_ids);
+
+  /**
+   * @brief Evaluates Variable bound with Bind()
+   * @param bch BranchChannels, one per branch id given to Bind()
+   */
+  double GetBoundValue(const std::vector<const BranchChannel*>& bch) const;
+
+  /**
+   * @brief Evaluates Variable of one branch for channels [first, last) of this branch
+   * @param out results are written to out[0] ... out[last - first - 1]
+   */
+  void GetValues(const Branch& branch, size_t first, size_t last, double* out) const;
+
+  ANALYSISTREE_ATTR_NODISCARD bool IsBound() const { return !slots_.empty() || fields_.empty(); }
   [[deprecated]] double GetValue(const BranchChannel& a, size_t a_id, const BranchChannel& b, size_t b_id) const;
 
   template<class T>
@@ -88,9 +136,14 @@ class Variable {
   std::string name_;
   std::vector<Field> fields_{};
   mutable std::vector<double> vars_{};                                                                    //!
+  Expression expression_{};                                                                               //! if not empty, used instead of lambda_
+  mutable std::vector<double> columns_{};                                                                 //! field values for GetValues(), field-major
+  std::vector<size_t> slots_{};                                                                           //! position of the branch of each field, see Bind()
   std::function<double(std::vector<double>&)> lambda_{[](std::vector<double>& var) { return var.at(0); }};//!
+  std::string version_{};                                                                                 //! see SetVersion()
   short n_branches_{0};
   bool is_init_{false};
+  bool is_lambda_{false};//! created with lambda, see IsDefinitionComplete()
   ClassDef(Variable, 0);
 };
 
@@ -7,6 +7,7 @@
 #include <gtest/gtest.h>
 
 #include <core/Track.hpp>
+#include <infra/Branch.hpp>
 #include <infra/Variable.hpp>
 
 #include <core/BranchConfig.hpp>
@@ -55,6 +56,37 @@ TEST(Variable, Basics) {
   EXPECT_FLOAT_EQ(var2.GetValue(track), 1.f);
 }
 
+TEST(Variable, Bind) {
+
+  BranchConfig branch_config("RecTrack", DetType::kTrack);
+  branch_config.AddField<float>("test_f", "test field");
+  Configuration configuration;
+  configuration.AddBranchConfig(branch_config);
+
+  auto* tracks = new TrackDetector(branch_config.GetId());
+  for (int i = 0; i < 10; ++i) {
+    auto& track = tracks->AddChannel(branch_config);
+    track.SetField(float(i), 0);
+    track.SetMomentum(1.f, 0.f, 0.f);
+  }
+  Branch branch(branch_config, tracks);
+
+  Variable var("var", {{"RecTrack", "test_f"}, {"RecTrack", "px"}}, [](std::vector<double>& var) { return var[0] + var[1]; });
+  var.Init(configuration);
+  EXPECT_THROW(var.Bind({branch_config.GetId() + 1}), std::runtime_error);
+  var.Bind({branch_config.GetId() + 1, branch_config.GetId()});
+
+  auto channel = branch[3];
+  std::vector<const BranchChannel*> bch{nullptr, &channel};
+  EXPECT_FLOAT_EQ(var.GetBoundValue(bch), 4.f);
+
+  std::vector<double> values(5);
+  var.GetValues(branch, 5, 10, values.data());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_FLOAT_EQ(values[i], 6.f + i);
+  }
+}
+
 }// namespace
 
 #endif//ANALYSISTREE_INFRA_VARIABLE_TEST_СPP_
@@ -7,9 +7,14 @@
 // I'm really sorry about this, blame Oleg
 // To be removed after c++17 will be available everywhere
 
+#include <algorithm>
+#include <stdexcept>
+
 #include "TTree.h"
 
 #include "Cuts.hpp"
+#include "FieldHandle.hpp"
+#include "KinematicsColumns.hpp"
 #include "Utils.hpp"
 #include "Variable.hpp"
 
@@ -39,7 +44,7 @@ struct clear_channels_struct : public Utils::Visitor<void> {
 };
 
 struct new_channel_struct : public Utils::Visitor<void> {
-  explicit new_channel_struct(BranchConfig* config) : config_(config) {}
+  explicit new_channel_struct(const BranchConfig* config) : config_(config) {}
   template<typename Entity>
   void new_channel(Entity* d) const {
     auto channel = d->AddChannel();
@@ -47,7 +52,7 @@ struct new_channel_struct : public Utils::Visitor<void> {
   }
   template<typename Entity>
   void operator()(Entity* d) const { new_channel<Entity>(d); }
-  BranchConfig* config_;
+  const BranchConfig* config_;
 };
 
 struct copy_content_struct : public Utils::Visitor<void> {
@@ -67,7 +72,7 @@ template<typename T>
 struct get_field_struct : public Utils::Visitor<double> {
   explicit get_field_struct(int id) : id_(id) {}
   template<typename Entity>
-  double get_field(Entity* d) const { return d->template GetField<T>(id_); }
+  double get_field(Entity* d) const { return FieldHandle<T, Entity>::Read(*d, id_); }
   template<typename Entity>
   double operator()(Entity* d) const { return get_field<Entity>(d); }
   int id_{-999};
@@ -77,13 +82,70 @@ template<typename T>
 struct set_field_struct : public Utils::Visitor<void> {
   set_field_struct(double value, int id) : value_(value), id_(id) {}
   template<typename Entity>
-  void set_field(Entity* d) const { d->template SetField<T>(value_, id_); }
+  void set_field(Entity* d) const { FieldHandle<T, Entity>::Write(*d, id_, value_); }
   template<typename Entity>
   void operator()(Entity* d) const { set_field<Entity>(d); }
   double value_{0.};
   int id_{-999};
 };
 
+/**
+ * @brief Reads one field of channels [first, first + n) into out.
+ * The handle is resolved once per call, so the loop is a plain gather over the channel vector.
+ * Kinematic default fields are taken from kinematics if it keeps them
+ */
+struct get_field_values_struct : public Utils::Visitor<void> {
+  get_field_values_struct(const Field& field, const KinematicsColumns* kinematics, size_t first, size_t n, double* out) : field_(field),
+                                                                                                                          kinematics_(kinematics),
+                                                                                                                          first_(first),
+                                                                                                                          n_(n),
+                                                                                                                          out_(out) {}
+  template<typename T, typename Entity>
+  void get_values(const Entity* channels) const {
+    const auto handle = field_.GetHandle<T, Entity>();
+    for (size_t i = 0; i < n_; ++i) {
+      out_[i] = handle.Get(channels[first_ + i]);
+    }
+  }
+  template<typename Entity>
+  void get_values_of(const Entity* channels) const {
+    if (kinematics_ != nullptr && field_.GetFieldId() < 0 && kinematics_->Read(field_.GetFieldId(), channels, first_, n_, out_)) {
+      return;
+    }
+    using AnalysisTree::Types;
+    switch (field_.GetFieldType()) {
+      case Types::kFloat: get_values<float>(channels); break;
+      case Types::kInteger: get_values<int>(channels); break;
+      case Types::kBool: get_values<bool>(channels); break;
+      default: {
+        if (field_.GetName() == "ones") {
+          std::fill(out_, out_ + n_, 1.);
+          break;
+        }
+        throw std::runtime_error("Field type is not correct!");
+      }
+    }
+  }
+  template<typename Entity>
+  void operator()(Detector<Entity>* d) const {
+    if (first_ + n_ > d->GetNumberOfChannels()) {
+      throw std::out_of_range("get_field_values_struct - channel range is out of the detector size");
+    }
+    get_values_of<Entity>(d->GetChannels()->data());
+  }
+  void operator()(EventHeader* d) const {
+    if (first_ + n_ > 1) {
+      throw std::out_of_range("get_field_values_struct - EventHeader has one channel");
+    }
+    get_values_of<EventHeader>(d);
+  }
+  const Field& field_;
+  const KinematicsColumns* kinematics_{nullptr};
+  size_t first_{0};
+  size_t n_{0};
+  double* out_{nullptr};
+};
+
 struct get_n_channels_struct : public Utils::Visitor<size_t> {
   template<class Det>
   size_t get_n_channels(Det* d) const { return d->GetNumberOfChannels(); }
@@ -91,6 +153,47 @@ struct get_n_channels_struct : public Utils::Visitor<size_t> {
   size_t operator()(Entity* d) const { return get_n_channels<Entity>(d); }
 };
 
+struct new_object_struct : public Utils::Visitor<BranchPointer> {
+  template<typename Entity>
+  BranchPointer new_object(Entity*) const { return BranchPointer(new Entity); }
+  template<typename Entity>
+  BranchPointer operator()(Entity* d) const { return new_object<Entity>(d); }
+};
+
+struct delete_object_struct : public Utils::Visitor<void> {
+  template<typename Entity>
+  void delete_object(Entity* d) const { delete d; }
+  template<typename Entity>
+  void operator()(Entity* d) const { delete_object<Entity>(d); }
+};
+
+struct swap_content_struct : public Utils::Visitor<void> {
+  explicit swap_content_struct(BranchPointer other) : other_(std::move(other)) {}
+  template<typename Entity>
+  void swap_content(Entity* d) const { std::swap(*d, *ANALYSISTREE_UTILS_GET<Entity*>(other_)); }
+  template<typename Entity>
+  void operator()(Entity* d) const { swap_content<Entity>(d); }
+  BranchPointer other_;
+};
+
+struct copy_object_struct : public Utils::Visitor<void> {
+  explicit copy_object_struct(BranchPointer other) : other_(std::move(other)) {}
+  template<typename Entity>
+  void copy_object(Entity* d) const { *ANALYSISTREE_UTILS_GET<Entity*>(other_) = *d; }
+  template<typename Entity>
+  void operator()(Entity* d) const { copy_object<Entity>(d); }
+  BranchPointer other_;
+};
+
+struct cache_kinematics_struct : public Utils::Visitor<void> {
+  explicit cache_kinematics_struct(KinematicsColumns& columns) : columns_(columns) {}
+  void operator()(TrackDetector* d) const { columns_.Fill(*d); }
+  void operator()(Particles* d) const { columns_.Fill(*d); }
+  template<typename Entity>
+  void operator()(Entity*) const {}
+  KinematicsColumns& columns_;
+};
+
 struct set_branch_address_struct : public Utils::Visitor<int> {
   set_branch_address_struct(TTree* tree, std::string name) : tree_(tree), name_(std::move(name)) {}
   template<class Det>
@@ -101,6 +204,21 @@ struct set_branch_address_struct : public Utils::Visitor<int> {
   std::string name_;
 };
 
+struct create_branch_struct : public Utils::Visitor<TBranch*> {
+  create_branch_struct(TTree* tree, std::string name, int basket_size, int split_level) : tree_(tree),
+                                                                                        name_(std::move(name)),
+                                                                                        basket_size_(basket_size),
+                                                                                        split_level_(split_level) {}
+  template<class Det>
+  TBranch* create_branch(Det*& d) const { return tree_->Branch(name_.c_str(), &d, basket_size_, split_level_); }
+  template<typename Entity>
+  TBranch* operator()(Entity*& d) const { return create_branch<Entity>(d); }
+  TTree* tree_{nullptr};
+  std::string name_;
+  int basket_size_{32000};
+  int split_level_{99};
+};
+
 }// namespace AnalysisTree
 
 #endif//ANALYSISTREE_INFRA_VARIANTMAGIC_HPP_